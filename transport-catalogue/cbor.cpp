@@ -0,0 +1,488 @@
+#include "cbor.h"
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace cbor {
+
+using namespace std::literals;
+
+namespace {
+
+// Старшие три бита первого байта элемента
+constexpr uint8_t UNSIGNED = 0;
+constexpr uint8_t NEGATIVE = 1;
+constexpr uint8_t BYTES = 2;
+constexpr uint8_t TEXT = 3;
+constexpr uint8_t ARRAY = 4;
+constexpr uint8_t MAP = 5;
+constexpr uint8_t TAG = 6;
+constexpr uint8_t SIMPLE = 7;
+
+// Младшие пять бит: значение или размер следующего за ним аргумента
+constexpr uint8_t ONE_BYTE = 24;
+constexpr uint8_t INDEFINITE = 31;
+
+constexpr uint8_t FALSE_VALUE = 20;
+constexpr uint8_t TRUE_VALUE = 21;
+constexpr uint8_t NULL_VALUE = 22;
+constexpr uint8_t UNDEFINED_VALUE = 23;
+constexpr uint8_t HALF_FLOAT = 25;
+constexpr uint8_t SINGLE_FLOAT = 26;
+constexpr uint8_t DOUBLE_FLOAT = 27;
+
+constexpr uint8_t BREAK = 0xFF;
+
+struct Head {
+    uint8_t major;
+    uint8_t info;
+    // Значение аргумента; для неопределённой длины не используется
+    uint64_t value;
+};
+
+// Непрерывный буфер входных данных с текущей позицией разбора
+struct Cursor {
+    const uint8_t* pos;
+    const uint8_t* end;
+    // Сюда склеиваются строки, записанные фрагментами
+    std::string chunks;
+};
+
+void Require(const Cursor& input, size_t size) {
+    if (static_cast<size_t>(input.end - input.pos) < size) {
+        throw json::ParsingError("Unexpected end of CBOR data");
+    }
+}
+
+uint64_t ReadBigEndian(Cursor& input, size_t size) {
+    Require(input, size);
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        value = (value << 8) | input.pos[i];
+    }
+    input.pos += size;
+    return value;
+}
+
+Head ReadHead(Cursor& input) {
+    Require(input, 1);
+    const uint8_t initial = *input.pos++;
+    Head head{ static_cast<uint8_t>(initial >> 5), static_cast<uint8_t>(initial & 0x1F), 0 };
+    if (head.info < ONE_BYTE) {
+        head.value = head.info;
+    }
+    else if (head.info <= DOUBLE_FLOAT) {
+        head.value = ReadBigEndian(input, size_t{ 1 } << (head.info - ONE_BYTE));
+    }
+    else if (head.info != INDEFINITE) {
+        throw json::ParsingError("Reserved CBOR argument size");
+    }
+    else if (head.major == SIMPLE) {
+        // Break внутри контейнера или строки поглощает AtBreak, сюда попадает лишний
+        throw json::ParsingError("Unexpected CBOR break");
+    }
+    else if (head.major == UNSIGNED || head.major == NEGATIVE || head.major == TAG) {
+        throw json::ParsingError("Indefinite length for CBOR number or tag");
+    }
+    return head;
+}
+
+bool AtBreak(const Cursor& input) {
+    Require(input, 1);
+    return *input.pos == BREAK;
+}
+
+size_t CheckedLength(const Cursor& input, uint64_t length) {
+    if (length > static_cast<uint64_t>(input.end - input.pos)) {
+        throw json::ParsingError("Unexpected end of CBOR data");
+    }
+    return static_cast<size_t>(length);
+}
+
+// Возвращает текст строки. Строка определённой длины указывает прямо во
+// входной буфер, записанная фрагментами — в input.chunks и действительна
+// до следующего вызова.
+std::string_view ReadString(Cursor& input, const Head& head) {
+    if (head.info != INDEFINITE) {
+        const size_t length = CheckedLength(input, head.value);
+        const std::string_view result(reinterpret_cast<const char*>(input.pos), length);
+        input.pos += length;
+        return result;
+    }
+    input.chunks.clear();
+    while (!AtBreak(input)) {
+        const Head chunk = ReadHead(input);
+        if (chunk.major != head.major || chunk.info == INDEFINITE) {
+            throw json::ParsingError("Invalid CBOR string chunk");
+        }
+        const size_t length = CheckedLength(input, chunk.value);
+        input.chunks.append(reinterpret_cast<const char*>(input.pos), length);
+        input.pos += length;
+    }
+    ++input.pos;
+    return input.chunks;
+}
+
+double DecodeHalf(uint16_t half) {
+    const int exponent = (half >> 10) & 0x1F;
+    const int mantissa = half & 0x3FF;
+    double value = 0;
+    if (exponent == 0) {
+        value = std::ldexp(mantissa, -24);
+    }
+    else if (exponent != 31) {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    }
+    else {
+        value = mantissa == 0 ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+void LoadSimple(const Head& head, json::Handler& handler) {
+    switch (head.info) {
+    case FALSE_VALUE:
+        handler.Bool(false);
+        break;
+    case TRUE_VALUE:
+        handler.Bool(true);
+        break;
+    case NULL_VALUE:
+    case UNDEFINED_VALUE:
+        handler.Null();
+        break;
+    case HALF_FLOAT:
+        handler.Double(DecodeHalf(static_cast<uint16_t>(head.value)));
+        break;
+    case SINGLE_FLOAT: {
+        const uint32_t bits = static_cast<uint32_t>(head.value);
+        float value = 0;
+        std::memcpy(&value, &bits, sizeof(value));
+        handler.Double(value);
+        break;
+    }
+    case DOUBLE_FLOAT: {
+        double value = 0;
+        std::memcpy(&value, &head.value, sizeof(value));
+        handler.Double(value);
+        break;
+    }
+    default:
+        throw json::ParsingError("Unsupported CBOR simple value");
+    }
+}
+
+void LoadItem(Cursor& input, json::Handler& handler) {
+    const Head head = ReadHead(input);
+    switch (head.major) {
+    case UNSIGNED:
+        if (head.value <= static_cast<uint64_t>(INT_MAX)) {
+            handler.Int(static_cast<int>(head.value));
+        }
+        else {
+            // Как и в JSON, целое вне диапазона int читается как double
+            handler.Double(static_cast<double>(head.value));
+        }
+        break;
+    case NEGATIVE:
+        // Значение кодируется как -1 - value
+        if (head.value <= static_cast<uint64_t>(INT_MAX)) {
+            handler.Int(-1 - static_cast<int>(head.value));
+        }
+        else {
+            handler.Double(-1.0 - static_cast<double>(head.value));
+        }
+        break;
+    case BYTES:
+    case TEXT:
+        handler.String(ReadString(input, head));
+        break;
+    case ARRAY:
+        handler.StartArray();
+        if (head.info == INDEFINITE) {
+            while (!AtBreak(input)) {
+                LoadItem(input, handler);
+            }
+            ++input.pos;
+        }
+        else {
+            for (uint64_t i = 0; i < head.value; ++i) {
+                LoadItem(input, handler);
+            }
+        }
+        handler.EndArray();
+        break;
+    case MAP: {
+        handler.StartDict();
+        const auto load_member = [&input, &handler] {
+            const Head key = ReadHead(input);
+            if (key.major != TEXT) {
+                throw json::ParsingError("CBOR map key is not a text string");
+            }
+            handler.Key(ReadString(input, key));
+            LoadItem(input, handler);
+        };
+        if (head.info == INDEFINITE) {
+            while (!AtBreak(input)) {
+                load_member();
+            }
+            ++input.pos;
+        }
+        else {
+            for (uint64_t i = 0; i < head.value; ++i) {
+                load_member();
+            }
+        }
+        handler.EndDict();
+        break;
+    }
+    case TAG:
+        // Теги (даты, большие числа и т.п.) модели не нужны: берётся само значение
+        LoadItem(input, handler);
+        break;
+    default:
+        LoadSimple(head, handler);
+        break;
+    }
+}
+
+// Пропускает элемент: строки и числа — по заголовку длины, контейнеры — поэлементно
+void SkipItem(Cursor& input) {
+    const Head head = ReadHead(input);
+    switch (head.major) {
+    case BYTES:
+    case TEXT:
+        if (head.info == INDEFINITE) {
+            ReadString(input, head);
+        }
+        else {
+            input.pos += CheckedLength(input, head.value);
+        }
+        break;
+    case ARRAY:
+    case MAP: {
+        if (head.info == INDEFINITE) {
+            while (!AtBreak(input)) {
+                SkipItem(input);
+            }
+            ++input.pos;
+            break;
+        }
+        const uint64_t count = head.major == MAP ? head.value * 2 : head.value;
+        for (uint64_t i = 0; i < count; ++i) {
+            SkipItem(input);
+        }
+        break;
+    }
+    case TAG:
+        SkipItem(input);
+        break;
+    default:
+        break;
+    }
+}
+
+Cursor MakeCursor(std::string_view data) {
+    const auto* begin = reinterpret_cast<const uint8_t*>(data.data());
+    return { begin, begin + data.size(), {} };
+}
+
+// Заголовок элемента: старшие 3 бита — тип, затем значение или длина.
+// Возвращает число записанных байт (не больше 9).
+size_t EncodeHead(char* bytes, uint8_t major, uint64_t value) {
+    size_t size = 1;
+    if (value < ONE_BYTE) {
+        // Малое значение помещается в первый байт
+        bytes[0] = static_cast<char>((major << 5) | value);
+    }
+    else {
+        int extra = 0;
+        while (extra < 3 && value >= (uint64_t{ 1 } << (8 << extra))) {
+            ++extra;
+        }
+        bytes[0] = static_cast<char>((major << 5) | (ONE_BYTE + extra));
+        const size_t length = size_t{ 1 } << extra;
+        for (; size <= length; ++size) {
+            bytes[size] = static_cast<char>(value >> (8 * (length - size)));
+        }
+    }
+    return size;
+}
+
+}  // namespace
+
+void Parse(std::string_view data, json::Handler& handler) {
+    Cursor input = MakeCursor(data);
+    LoadItem(input, handler);
+}
+
+void Parse(std::istream& input, json::Handler& handler) {
+    const std::string data = json::ReadAll(input);
+    cbor::Parse(std::string_view(data), handler);
+}
+
+json::Sections SplitSections(std::string_view data, const json::Sections::Selector& select) {
+    Cursor input = MakeCursor(data);
+    if (input.pos == input.end || (*input.pos >> 5) != MAP) {
+        return json::Sections(false, {});
+    }
+    const Head head = ReadHead(input);
+    std::vector<std::pair<std::string, std::string_view>> sections;
+    for (uint64_t i = 0; head.info == INDEFINITE ? !AtBreak(input) : i < head.value; ++i) {
+        const Head key_head = ReadHead(input);
+        if (key_head.major != TEXT) {
+            throw json::ParsingError("CBOR map key is not a text string");
+        }
+        std::string key(ReadString(input, key_head));
+        const uint8_t* start = input.pos;
+        if (json::Handler* handler = select ? select(key) : nullptr) {
+            LoadItem(input, *handler);
+        }
+        else {
+            SkipItem(input);
+        }
+        sections.emplace_back(std::move(key),
+            std::string_view(reinterpret_cast<const char*>(start), input.pos - start));
+    }
+    return json::Sections(true, std::move(sections));
+}
+
+json::Document Load(std::istream& input) {
+    json::NodeHandler handler;
+    cbor::Parse(input, handler);
+    return json::Document{ handler.Extract() };
+}
+
+void Print(const json::Document& doc, std::ostream& output) {
+    Writer writer(output);
+    writer.Value(doc.GetRoot());
+}
+
+Writer::Writer(std::ostream& out, size_t buffer_size)
+    : out_(out)
+    , buffer_size_(buffer_size) {
+    buffer_.reserve(buffer_size_);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::Null() {
+    AppendHead(SIMPLE, NULL_VALUE);
+}
+
+void Writer::Bool(bool value) {
+    AppendHead(SIMPLE, value ? TRUE_VALUE : FALSE_VALUE);
+}
+
+void Writer::Int(int value) {
+    if (value >= 0) {
+        AppendHead(UNSIGNED, static_cast<uint64_t>(value));
+    }
+    else {
+        AppendHead(NEGATIVE, static_cast<uint64_t>(-1 - static_cast<int64_t>(value)));
+    }
+}
+
+void Writer::Double(double value) {
+    // Число, которое float хранит без потерь, занимает вдвое меньше места.
+    // Приведение вне диапазона float — неопределённое поведение, поэтому
+    // бесконечности, NaN и большие числа сразу пишутся как double.
+    const bool fits = std::isfinite(value) && std::fabs(value) <= FLT_MAX;
+    const float narrow = fits ? static_cast<float>(value) : 0.0f;
+    char bytes[9];
+    size_t size = 0;
+    if (fits && static_cast<double>(narrow) == value) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &narrow, sizeof(bits));
+        bytes[0] = static_cast<char>((SIMPLE << 5) | SINGLE_FLOAT);
+        for (size = 1; size <= 4; ++size) {
+            bytes[size] = static_cast<char>(bits >> (8 * (4 - size)));
+        }
+    }
+    else {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bytes[0] = static_cast<char>((SIMPLE << 5) | DOUBLE_FLOAT);
+        for (size = 1; size <= 8; ++size) {
+            bytes[size] = static_cast<char>(bits >> (8 * (8 - size)));
+        }
+    }
+    Append({ bytes, size });
+}
+
+void Writer::String(std::string_view value) {
+    AppendText(value);
+}
+
+void Writer::StartArray() {
+    AppendIndefinite(ARRAY);
+}
+
+void Writer::EndArray() {
+    Append("\xFF"sv);
+}
+
+void Writer::StartDict() {
+    AppendIndefinite(MAP);
+}
+
+void Writer::Key(std::string_view key) {
+    AppendText(key);
+}
+
+void Writer::EndDict() {
+    Append("\xFF"sv);
+}
+
+std::string Writer::EncodeString(std::string_view value) const {
+    char head[9];
+    const size_t head_size = EncodeHead(head, TEXT, value.size());
+    std::string encoded;
+    encoded.reserve(head_size + value.size());
+    encoded.append(head, head_size);
+    encoded.append(value);
+    return encoded;
+}
+
+void Writer::Encoded(std::string_view value) {
+    Append(value);
+}
+
+void Writer::Flush() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::AppendHead(uint8_t major, uint64_t value) {
+    char bytes[9];
+    Append({ bytes, EncodeHead(bytes, major, value) });
+}
+
+void Writer::AppendIndefinite(uint8_t major) {
+    const char initial = static_cast<char>((major << 5) | INDEFINITE);
+    Append({ &initial, 1 });
+}
+
+void Writer::AppendText(std::string_view text) {
+    AppendHead(TEXT, text.size());
+    Append(text);
+}
+
+void Writer::Append(std::string_view bytes) {
+    if (bytes.size() >= buffer_size_) {
+        // Длинный участок пишется в поток напрямую, минуя буфер
+        Flush();
+        out_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return;
+    }
+    buffer_.append(bytes);
+    if (buffer_.size() >= buffer_size_) {
+        Flush();
+    }
+}
+
+}  // namespace cbor
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "json.h"
+#include "json_writer.h"
+
+// Двоичное представление той же модели json::Node в формате CBOR (RFC 8949).
+// Числа хранятся в двоичном виде, поэтому ни разбор, ни вывод не тратят
+// время на преобразование в текст. Контейнеры пишутся с неопределённой
+// длиной, так что документ выводится потоково, как и JSON.
+namespace cbor {
+
+// Разбирает один элемент CBOR, передавая события обработчику. Ключи словарей
+// должны быть текстовыми строками, целые вне диапазона int читаются как
+// double. Строки определённой длины указывают прямо в data.
+void Parse(std::string_view data, json::Handler& handler);
+void Parse(std::istream& input, json::Handler& handler);
+
+// Размечает словарь верхнего уровня, как json::Sections: выбранные разделы
+// разбираются сразу, остальные пропускаются по заголовкам длины
+json::Sections SplitSections(std::string_view data, const json::Sections::Selector& select = {});
+
+json::Document Load(std::istream& input);
+void Print(const json::Document& doc, std::ostream& output);
+
+class Writer final : public json::ValueWriter {
+public:
+    explicit Writer(std::ostream& out, size_t buffer_size = 1 << 20);
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    ~Writer() override;
+
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+
+    std::string EncodeString(std::string_view value) const override;
+    void Encoded(std::string_view value) override;
+
+    void Flush() override;
+
+private:
+    void AppendHead(uint8_t major, uint64_t value);
+    // Начало контейнера неопределённой длины; конец — байт 0xFF
+    void AppendIndefinite(uint8_t major);
+    void AppendText(std::string_view text);
+    void Append(std::string_view bytes);
+
+    std::ostream& out_;
+    size_t buffer_size_;
+    std::string buffer_;
+};
+
+}  // namespace cbor
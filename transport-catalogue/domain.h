@@ -1,20 +1,82 @@
 #pragma once
-#include <string>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
 #include <vector>
 #include "geo.h"
+#include "ranges.h"
 namespace catalogue {
 namespace detail {
 struct Stop {
-	Stop(std::string n, double lat, double lng) :name{ n }, latitude{ lat }, longitude{ lng } {}
-	std::string name;
+	Stop(std::string_view n, double lat, double lng) :name{ n }, latitude{ lat }, longitude{ lng } {
+		const geo::PreparedCoordinates prepared = geo::Prepare({ lat, lng });
+		sin_latitude = prepared.sin_lat;
+		cos_latitude = prepared.cos_lat;
+	}
+	geo::PreparedCoordinates GetPreparedCoordinates() const {
+		return { latitude, longitude, sin_latitude, cos_latitude };
+	}
+	std::string_view name;
 	double latitude;
 	double longitude;
+	double sin_latitude;
+	double cos_latitude;
+	size_t id = 0;
+};
+
+// Обходит полный маршрут: для некольцевого маршрута после прямого хода
+// остановки выдаются в обратном порядке, без хранения второй половины
+class RouteIterator {
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = Stop*;
+	using difference_type = std::ptrdiff_t;
+	using pointer = Stop* const*;
+	using reference = Stop* const&;
+
+	RouteIterator(const std::vector<Stop*>& stops, size_t index) :stops_(&stops), index_(index) {}
+
+	reference operator*() const {
+		return index_ < stops_->size() ? (*stops_)[index_] : (*stops_)[2 * stops_->size() - 2 - index_];
+	}
+	RouteIterator& operator++() {
+		++index_;
+		return *this;
+	}
+	RouteIterator operator++(int) {
+		RouteIterator result = *this;
+		++index_;
+		return result;
+	}
+	bool operator==(const RouteIterator& other) const {
+		return index_ == other.index_;
+	}
+	bool operator!=(const RouteIterator& other) const {
+		return index_ != other.index_;
+	}
+
+private:
+	const std::vector<Stop*>* stops_;
+	size_t index_;
 };
 
 struct Bus {
-	Bus(std::string n, std::vector<Stop*> st) :name{ n }, stops{ st } {}
-	std::string name;
+	Bus(std::string_view n, std::vector<Stop*> st, bool roundtrip) :name{ n }, stops{ std::move(st) }, is_roundtrip{ roundtrip } {}
+
+	// Число остановок полного маршрута, включая обратный ход некольцевого
+	size_t GetStopCount() const {
+		return is_roundtrip || stops.empty() ? stops.size() : 2 * stops.size() - 1;
+	}
+	ranges::Range<RouteIterator> GetRoute() const {
+		return { RouteIterator(stops, 0), RouteIterator(stops, GetStopCount()) };
+	}
+
+	std::string_view name;
+	// Для некольцевого маршрута хранится только прямой ход
 	std::vector<Stop*> stops;
+	bool is_roundtrip;
+	// Число разных остановок, считается при добавлении маршрута
+	size_t unique_stop_count = 0;
 };
 
 struct StopsPairHasher {
@@ -24,4 +24,31 @@ inline double ComputeDistance(Coordinates from, Coordinates to) {
         + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
         * earth_radius;
 }
+
+// Координаты с заранее вычисленными синусом и косинусом широты
+struct PreparedCoordinates {
+    double lat;
+    double lng;
+    double sin_lat;
+    double cos_lat;
+};
+
+inline PreparedCoordinates Prepare(Coordinates coordinates) {
+    static const double dr = 3.1415926535 / 180.;
+    return { coordinates.lat, coordinates.lng, std::sin(coordinates.lat * dr), std::cos(coordinates.lat * dr) };
+}
+
+// Совпадает с ComputeDistance(Coordinates, Coordinates) бит в бит,
+// но вычисляет только косинус разности долгот и арккосинус
+inline double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to) {
+    using namespace std;
+    const int earth_radius = 6371000;
+    if (from.lat == to.lat && from.lng == to.lng) {
+        return 0;
+    }
+    static const double dr = 3.1415926535 / 180.;
+    return acos(from.sin_lat * to.sin_lat
+        + from.cos_lat * to.cos_lat * cos(abs(from.lng - to.lng) * dr))
+        * earth_radius;
+}
 }
\ No newline at end of file
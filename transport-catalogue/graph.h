@@ -15,8 +15,8 @@ struct Edge {
     VertexId from;
     VertexId to;
     Weight weight;
-    std::string bus;
-    std::string stop;
+    std::string_view bus;
+    std::string_view stop;
     int span_count = 0;
 };
 
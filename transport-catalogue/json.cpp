@@ -1,4 +1,14 @@
 #include "json.h"
+#include "json_scan.h"
+#include "json_writer.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -6,15 +16,59 @@ namespace json {
 
 namespace {
 
-Node LoadNode(istream& input);
+// Непрерывный буфер входных данных с текущей позицией разбора
+struct Cursor {
+    const char* pos;
+    const char* end;
+    // Строки с escape-последовательностями раскрываются сюда
+    std::string unescaped{};
+};
+
+using scan::FindStringSpecial;
+using scan::FindStructural;
+using scan::IsSpace;
+using scan::SkipSpaces;
+
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool IsAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// Пропускает пробельные символы и возвращает следующий символ, как input >> c
+bool NextChar(Cursor& input, char& c) {
+    input.pos = SkipSpaces(input.pos, input.end);
+    if (input.pos == input.end) {
+        return false;
+    }
+    c = *input.pos++;
+    return true;
+}
 
-Node LoadString(std::istream& input) {
+void LoadNode(Cursor& input, Handler& handler);
+
+// Возвращает строку без кавычек. Если escape-последовательностей нет,
+// результат указывает прямо во входной буфер, иначе — в input.unescaped
+// и действителен до следующего вызова.
+std::string_view LoadString(Cursor& input) {
     using namespace std::literals;
 
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
+    const char* it = FindStringSpecial(input.pos, input.end);
+    const char* end = input.end;
+    if (it != end && *it == '"') {
+        const std::string_view result(input.pos, it - input.pos);
+        input.pos = it + 1;
+        return result;
+    }
+    std::string& s = input.unescaped;
+    s.assign(input.pos, it);
     while (true) {
+        // Копируем участок без специальных символов целиком
+        const char* run = it;
+        it = FindStringSpecial(it, end);
+        s.append(run, it);
         if (it == end) {
             // Поток закончился до того, как встретили закрывающую кавычку?
             throw ParsingError("String parsing error");
@@ -54,52 +108,40 @@ Node LoadString(std::istream& input) {
                 // Встретили неизвестную escape-последовательность
                 throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
             }
+            ++it;
         }
-        else if (ch == '\n' || ch == '\r') {
+        else {
             // Строковый литерал внутри- JSON не может прерываться символами \r или \n
             throw ParsingError("Unexpected end of line"s);
         }
-        else {
-            // Просто считываем очередной символ и помещаем его в результирующую строку
-            s.push_back(ch);
-        }
-        ++it;
     }
-
-    return Node{ s };
+    input.pos = it;
+    return s;
 }
 
-using Number = std::variant<int, double>;
-
-Node LoadNumber(std::istream& input) {
+void LoadNumber(Cursor& input, Handler& handler) {
     using namespace std::literals;
 
-    std::string parsed_num;
-
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-        };
+    const char* start = input.pos;
+    const char* it = input.pos;
+    const char* end = input.end;
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
+    // Пропускает одну или более цифр
+    auto read_digits = [&it, end] {
+        if (it == end || !IsDigit(*it)) {
             throw ParsingError("A digit is expected"s);
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        while (it != end && IsDigit(*it)) {
+            ++it;
         }
         };
 
-    if (input.peek() == '-') {
-        read_char();
+    if (it != end && *it == '-') {
+        ++it;
     }
     // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
+    if (it != end && *it == '0') {
+        ++it;
         // После 0 в JSON не могут идти другие цифры
     }
     else {
@@ -108,122 +150,227 @@ Node LoadNumber(std::istream& input) {
 
     bool is_int = true;
     // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
+    if (it != end && *it == '.') {
+        ++it;
         read_digits();
         is_int = false;
     }
 
     // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    if (it != end && (*it == 'e' || *it == 'E')) {
+        ++it;
+        if (it != end && (*it == '+' || *it == '-')) {
+            ++it;
         }
         read_digits();
         is_int = false;
     }
+    input.pos = it;
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return Node(std::stoi(parsed_num));
-            }
-            catch (...) {
-                // В случае неудачи, например, при переполнении,
-                // код ниже попробует преобразовать строку в double
-            }
+    if (is_int) {
+        int value_int = 0;
+        const auto result = std::from_chars(start, it, value_int);
+        if (result.ec == std::errc{}) {
+            handler.Int(value_int);
+            return;
         }
-        return Node(std::stod(parsed_num));
+        // При переполнении int число читается как double
     }
-    catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+    double value_double = 0;
+    const auto result = std::from_chars(start, it, value_double);
+    if (result.ec != std::errc{}) {
+        throw ParsingError("Failed to convert "s + std::string(start, it) + " to number"s);
     }
+    handler.Double(value_double);
 }
 
-Node LoadArray(istream& input) {
-    Array result;
-    char c;
-    for (; input >> c && c != ']';) {
+void LoadArray(Cursor& input, Handler& handler) {
+    handler.StartArray();
+    char c = 0;
+    for (; NextChar(input, c) && c != ']';) {
         if (c != ',') {
-            input.putback(c);
+            --input.pos;
         }
-        result.push_back(LoadNode(input));
+        LoadNode(input, handler);
     }
     if (c != ']') {
         throw ParsingError("No ]");
     }
-    return Node(move(result));
+    handler.EndArray();
 }
 
 
-Node LoadDict(istream& input) {
-    Dict result;
-    char c;
-    for (; input >> c && c != '}';) {
+void LoadDict(Cursor& input, Handler& handler) {
+    handler.StartDict();
+    char c = 0;
+    for (; NextChar(input, c) && c != '}';) {
         if (c == ',') {
-            input >> c;
+            NextChar(input, c);
         }
 
-        string key = LoadString(input).AsString();
-        input >> c;
-        result.insert({move(key), LoadNode(input)});
+        handler.Key(LoadString(input));
+        NextChar(input, c);
+        LoadNode(input, handler);
     }
     if (c != '}') {
         throw ParsingError("No }");
     }
-    return Node(move(result));
+    handler.EndDict();
 }
 
-Node LoadOther(istream& input) {
-    string str;
-    char c;
-    while ((c = static_cast<char>(input.get())) && std::isalpha(c))
-    {
-        str += c;
-    }
-    if (!std::isalpha(c))
-    {
-        input.putback(c);
+void LoadOther(Cursor& input, Handler& handler) {
+    using namespace std::literals;
+
+    const char* start = input.pos;
+    while (input.pos != input.end && IsAlpha(*input.pos)) {
+        ++input.pos;
     }
-    if (str == "null" || str == "nullptr")
+    const std::string_view str(start, input.pos - start);
+    if (str == "null"sv || str == "nullptr"sv)
     {
-        return Node(nullptr);
+        handler.Null();
+        return;
     }
-    if (str == "true" || str == "false")
+    if (str == "true"sv || str == "false"sv)
     {
-        return Node(str == "true");
+        handler.Bool(str == "true"sv);
+        return;
     }
     throw ParsingError("Unknown type"s);
 }
 
-Node LoadNode(istream& input) {
-    char c;
-    input >> c;
+void LoadNode(Cursor& input, Handler& handler) {
+    char c = 0;
+    NextChar(input, c);
 
     if (c == '[') {
-        return LoadArray(input);
+        LoadArray(input, handler);
     } else if (c == '{') {
-        //input.putback(c);
-        return LoadDict(input);
+        LoadDict(input, handler);
     } else if (c == '"') {
-        //input.putback(c);
-        return LoadString(input);
-    } else if(isdigit(c) || c=='-'||c=='+') {
-        input.putback(c);
-        return LoadNumber(input);
+        handler.String(LoadString(input));
+    } else if(IsDigit(c) || c=='-'||c=='+') {
+        --input.pos;
+        LoadNumber(input, handler);
     }
-    else if (isalpha(c)) {
-        input.putback(c);
-        return LoadOther(input);
+    else if (IsAlpha(c)) {
+        --input.pos;
+        LoadOther(input, handler);
     }
-    return Node();
+    else {
+        handler.Null();
+    }
+}
 
+// Пропускает строку после открывающей кавычки, не раскрывая escape-последовательности
+void SkipString(Cursor& input) {
+    const char* it = input.pos;
+    while (true) {
+        it = FindStringSpecial(it, input.end);
+        if (it == input.end) {
+            throw ParsingError("String parsing error");
+        }
+        if (*it == '"') {
+            break;
+        }
+        if (*it == '\\') {
+            // За обратной косой чертой идёт экранированный символ, в том числе кавычка
+            if (input.end - it < 2) {
+                throw ParsingError("String parsing error");
+            }
+            ++it;
+        }
+        ++it;
+    }
+    input.pos = it + 1;
+}
+
+// Пропускает значение, не разбирая его. Для контейнера достаточно найти
+// парную скобку, учитывая только кавычки и скобки; содержимое не проверяется.
+void SkipValue(Cursor& input) {
+    char c = 0;
+    if (!NextChar(input, c)) {
+        return;
+    }
+    if (c == '"') {
+        SkipString(input);
+        return;
+    }
+    if (c != '[' && c != '{') {
+        // Число или литерал тянется до разделителя
+        while (input.pos != input.end && *input.pos != ',' && *input.pos != '}' && *input.pos != ']'
+            && !IsSpace(*input.pos)) {
+            ++input.pos;
+        }
+        return;
+    }
+    int depth = 1;
+    while (depth > 0) {
+        input.pos = FindStructural(input.pos, input.end);
+        if (input.pos == input.end) {
+            throw ParsingError(c == '[' ? "No ]" : "No }");
+        }
+        const char ch = *input.pos++;
+        if (ch == '"') {
+            SkipString(input);
+        }
+        else if (ch == '[' || ch == '{') {
+            ++depth;
+        }
+        else {
+            --depth;
+        }
+    }
+}
+
+// Пропускает массив после открывающей скобки, как SkipValue, и делит его на
+// части из целых элементов не меньше part_size байт
+void SkipArray(Cursor& input, size_t part_size, std::vector<std::string_view>& parts) {
+    const char* part_begin = input.pos;
+    char c = 0;
+    while (NextChar(input, c) && c != ']') {
+        if (c != ',') {
+            --input.pos;
+        }
+        SkipValue(input);
+        if (static_cast<size_t>(input.pos - part_begin) >= part_size) {
+            parts.emplace_back(part_begin, input.pos - part_begin);
+            part_begin = input.pos;
+        }
+    }
+    if (c != ']') {
+        throw ParsingError("No ]");
+    }
+    // Закрывающая скобка уже прочитана и в часть не входит
+    const char* part_end = input.pos - 1;
+    if (SkipSpaces(part_begin, part_end) != part_end) {
+        parts.emplace_back(part_begin, part_end - part_begin);
+    }
 }
 
 }  // namespace
 
+// Читает поток целиком крупными блоками, минуя посимвольный доступ
+std::string ReadAll(std::istream& input) {
+    constexpr size_t CHUNK_SIZE = 1 << 16;
+    std::string buffer;
+    std::streambuf* stream = input.rdbuf();
+    if (stream == nullptr) {
+        return buffer;
+    }
+    while (true) {
+        const size_t old_size = buffer.size();
+        buffer.resize(old_size + CHUNK_SIZE);
+        const std::streamsize read = stream->sgetn(buffer.data() + old_size, CHUNK_SIZE);
+        buffer.resize(old_size + static_cast<size_t>(std::max<std::streamsize>(read, 0)));
+        if (read < static_cast<std::streamsize>(CHUNK_SIZE)) {
+            break;
+        }
+    }
+    input.setstate(std::ios::eofbit);
+    return buffer;
+}
+
 Node::Node(std::nullptr_t value)
     :node_(move(value)){
 }
@@ -362,20 +509,203 @@ const Node& Document::GetRoot() const {
     return root_;
 }
 
-Document Load(istream& input) {
-    return Document{LoadNode(input)};
+void NodeHandler::Null() {
+    AddValue(Node(nullptr));
 }
 
-void Print(const Document& doc, std::ostream& output) {
-    if (doc.GetRoot().IsNull()) {
-        std::visit(OstreamNode{ output }, doc.GetRoot().GetValue());
-    }else if(doc.GetRoot().IsInt()||doc.GetRoot().IsDouble()){
-        std::visit(OstreamNode{ output }, doc.GetRoot().GetValue());
+void NodeHandler::Bool(bool value) {
+    AddValue(Node(value));
+}
+
+void NodeHandler::Int(int value) {
+    AddValue(Node(value));
+}
+
+void NodeHandler::Double(double value) {
+    AddValue(Node(value));
+}
+
+void NodeHandler::String(std::string_view value) {
+    AddValue(Node(std::string(value)));
+}
+
+void NodeHandler::StartArray() {
+    stack_.emplace_back(Array{});
+}
+
+void NodeHandler::EndArray() {
+    EndContainer();
+}
+
+void NodeHandler::StartDict() {
+    stack_.emplace_back(Dict{});
+}
+
+void NodeHandler::Key(std::string_view key) {
+    keys_.emplace_back(key);
+}
+
+void NodeHandler::EndDict() {
+    EndContainer();
+}
+
+Node NodeHandler::Extract() {
+    return move(root_);
+}
+
+void NodeHandler::EndContainer() {
+    Node value = move(stack_.back());
+    stack_.pop_back();
+    AddValue(move(value));
+}
+
+void NodeHandler::AddValue(Node value) {
+    if (stack_.empty()) {
+        root_ = move(value);
+    }
+    else if (auto* array = std::get_if<Array>(&stack_.back().GetValue())) {
+        array->push_back(move(value));
     }
     else {
-        std::visit(OstreamNode{ output }, doc.GetRoot().GetValue());
+        std::get<Dict>(stack_.back().GetValue()).insert({ move(keys_.back()), move(value) });
+        keys_.pop_back();
     }
-    
+}
+
+void Parse(std::string_view text, Handler& handler) {
+    Cursor input{ text.data(), text.data() + text.size() };
+    LoadNode(input, handler);
+    if (SkipSpaces(input.pos, input.end) != input.end) {
+        throw ParsingError("Unexpected data after JSON value");
+    }
+}
+
+void Parse(istream& input, Handler& handler) {
+    const std::string text = ReadAll(input);
+    Parse(std::string_view(text), handler);
+}
+
+MappedFile::MappedFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open "s + path);
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat "s + path);
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ > 0) {
+        void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to map "s + path);
+        }
+        data_ = static_cast<const char*>(data);
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+std::string_view MappedFile::GetText() const {
+    return { data_, size_ };
+}
+
+void ParseArrayPart(std::string_view part, Handler& handler) {
+    Cursor input{ part.data(), part.data() + part.size() };
+    handler.StartArray();
+    char c = 0;
+    while (NextChar(input, c)) {
+        // Участок, кроме первого, начинается с запятой после предыдущего элемента
+        if (c != ',') {
+            --input.pos;
+        }
+        LoadNode(input, handler);
+    }
+    handler.EndArray();
+}
+
+Sections::Sections(std::string_view text, const Selector& select, size_t part_size) {
+    Cursor input{ text.data(), text.data() + text.size() };
+    char c = 0;
+    if (!NextChar(input, c) || c != '{') {
+        return;
+    }
+    is_map_ = true;
+    while (NextChar(input, c) && c != '}') {
+        if (c == ',') {
+            NextChar(input, c);
+        }
+        std::string key(LoadString(input));
+        NextChar(input, c);
+        const char* start = SkipSpaces(input.pos, input.end);
+        input.pos = start;
+        if (Handler* handler = select ? select(key) : nullptr) {
+            LoadNode(input, *handler);
+        }
+        else if (part_size > 0 && input.pos != input.end && *input.pos == '[') {
+            ++input.pos;
+            std::vector<std::string_view> parts;
+            SkipArray(input, part_size, parts);
+            parts_.emplace_back(sections_.size(), std::move(parts));
+        }
+        else {
+            SkipValue(input);
+        }
+        sections_.emplace_back(std::move(key), std::string_view(start, input.pos - start));
+    }
+    if (c != '}') {
+        throw ParsingError("No }");
+    }
+}
+
+Sections::Sections(bool is_map, std::vector<std::pair<std::string, std::string_view>> sections)
+    : is_map_(is_map)
+    , sections_(std::move(sections)) {
+}
+
+bool Sections::IsMap() const {
+    return is_map_;
+}
+
+const std::string_view* Sections::Find(std::string_view key) const {
+    for (const auto& [name, text] : sections_) {
+        if (name == key) {
+            return &text;
+        }
+    }
+    return nullptr;
+}
+
+const std::vector<std::string_view>* Sections::FindParts(std::string_view key) const {
+    const auto it = std::find_if(sections_.begin(), sections_.end(), [key](const auto& section) {
+        return section.first == key;
+    });
+    const size_t index = it - sections_.begin();
+    for (const auto& [section, parts] : parts_) {
+        if (section == index) {
+            return &parts;
+        }
+    }
+    return nullptr;
+}
+
+Document Load(istream& input) {
+    NodeHandler handler;
+    Parse(input, handler);
+    return Document{handler.Extract()};
+}
+
+void Print(const Document& doc, std::ostream& output) {
+    Writer writer(output);
+    writer.Value(doc.GetRoot());
 }
 
 }  // namespace json
\ No newline at end of file
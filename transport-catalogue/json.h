@@ -1,10 +1,15 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
+
+#include "number_format.h"
+
 namespace json {
 class Node;
 struct OstreanNode;
@@ -78,11 +83,11 @@ struct OstreamNode {
     std::ostream& out;
 
     void operator()(const int& value) const {
-        out << value;
+        format::WriteInteger(out, value);
     }
 
     void operator()(const double& value) const {
-        out << value;
+        format::WriteDouble(out, value);
     }
 
     void operator()(const std::nullptr_t& value [[maybe_unused]] ) const {
@@ -112,7 +117,7 @@ struct OstreamNode {
     void operator()(const Dict& value) const {
         bool is_first = true;
         out << "{\n";
-        for (auto elem:value) {
+        for (const auto& elem : value) {
             if (!is_first) {
                 out << ",\n";
             }
@@ -163,6 +168,112 @@ private:
     Node root_;
 };
 
+// Обработчик событий потокового разбора. Строки и ключи передаются через
+// string_view, действительный только на время вызова. Исключение: при
+// разборе из буфера строки без escape-последовательностей указывают прямо
+// в него и живут, пока жив буфер.
+class Handler {
+public:
+    virtual void Null() = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Int(int value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void String(std::string_view value) = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void StartDict() = 0;
+    virtual void Key(std::string_view key) = 0;
+    virtual void EndDict() = 0;
+
+    virtual ~Handler() = default;
+};
+
+// Собирает дерево Node из событий разбора
+class NodeHandler final : public Handler {
+public:
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+
+    Node Extract();
+
+private:
+    void EndContainer();
+    void AddValue(Node value);
+
+    Node root_;
+    std::vector<Node> stack_;
+    std::vector<std::string> keys_;
+};
+
+// Отображение файла в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    std::string_view GetText() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Разбирает один JSON-документ, передавая события обработчику. После
+// значения допустимы только пробельные символы. Разбор идёт по
+// непрерывному буферу: поток читается до конца крупными блоками.
+void Parse(std::string_view text, Handler& handler);
+void Parse(std::istream& input, Handler& handler);
+
+// Читает поток до конца крупными блоками
+std::string ReadAll(std::istream& input);
+
+// Разбирает часть массива, найденную Sections, как отдельный массив:
+// обработчик получает StartArray, элементы части и EndArray
+void ParseArrayPart(std::string_view part, Handler& handler);
+
+// Словарь верхнего уровня, разделы которого разбираются по требованию:
+// границы значений находятся сопоставлением скобок без разбора содержимого,
+// поэтому ненужный раздел стоит только быстрого просмотра. Текст должен
+// жить, пока используются найденные разделы.
+class Sections {
+public:
+    // Для каждого раздела вызывается select: если он вернул обработчик,
+    // раздел сразу разбирается в него, а не пропускается
+    using Selector = std::function<Handler*(std::string_view key)>;
+
+    // Пропускаемый раздел-массив заодно делится на части из целых элементов
+    // не меньше part_size байт, если part_size не 0
+    explicit Sections(std::string_view text, const Selector& select = {}, size_t part_size = 0);
+    // Разметка, найденная разбором другого формата (см. cbor::SplitSections)
+    Sections(bool is_map, std::vector<std::pair<std::string, std::string_view>> sections);
+
+    // Корень документа — словарь; иначе разделов нет
+    bool IsMap() const;
+    // Текст значения раздела или nullptr, если раздела нет. Из повторяющихся
+    // ключей, как и в Dict, учитывается первый.
+    const std::string_view* Find(std::string_view key) const;
+    // Части раздела-массива или nullptr, если раздел не делился
+    const std::vector<std::string_view>* FindParts(std::string_view key) const;
+
+private:
+    bool is_map_ = false;
+    std::vector<std::pair<std::string, std::string_view>> sections_;
+    // Части разделов по их номерам в sections_
+    std::vector<std::pair<size_t, std::vector<std::string_view>>> parts_;
+};
+
 Document Load(std::istream& input);
 
 void Print(const Document& doc, std::ostream& output);
@@ -7,20 +7,49 @@ Builder::Builder()
 	nodes_stack_.emplace_back(&root_);
 }
 
-Builder::DictValueContext Builder::Key(std::string key)
+Builder::Builder(ValueWriter& writer) :writer_(&writer)
 {
+	slots_.push_back(Slot::VALUE);
+}
+
+Builder::DictValueContext Builder::Key(std::string_view key)
+{
+	if (writer_) {
+		if (slots_.empty()) {
+			throw std::logic_error("Object already done");
+		}
+		if (slots_.back() != Slot::DICT) {
+			throw std::logic_error("No start dict before key");
+		}
+		writer_->Key(key);
+		slots_.push_back(Slot::VALUE);
+		return BaseContext(*this);
+	}
 	if (nodes_stack_.empty()) {
 		throw std::logic_error("Object already done");
 	}
 	if (!std::holds_alternative<Dict>(nodes_stack_.back()->GetValue())) {
 		throw std::logic_error("No start dict before key");
 	}
-	nodes_stack_.push_back(&std::get<Dict>(nodes_stack_.back()->GetValue())[std::move(key)]);
+	nodes_stack_.push_back(&std::get<Dict>(nodes_stack_.back()->GetValue())[std::string(key)]);
 	return BaseContext(*this);
 }
 
 Builder::BaseContext Builder::Value(Node::Value value)
 {
+	if (writer_) {
+		if (slots_.empty()) {
+			throw std::logic_error("Object already done");
+		}
+		if (slots_.back() == Slot::DICT) {
+			throw std::logic_error("Error space for value");
+		}
+		WriteValue(std::move(value));
+		if (slots_.back() == Slot::VALUE) {
+			slots_.pop_back();
+		}
+		return BaseContext(*this);
+	}
 	if (nodes_stack_.empty()) {
 		throw std::logic_error("Object already done");
 	}
@@ -38,8 +67,42 @@ Builder::BaseContext Builder::Value(Node::Value value)
 	throw std::logic_error("Error space for value");
 }
 
+Builder::BaseContext Builder::StringValue(std::string_view value)
+{
+	if (!writer_) {
+		return Value(Node::Value(std::string(value)));
+	}
+	if (slots_.empty()) {
+		throw std::logic_error("Object already done");
+	}
+	if (slots_.back() == Slot::DICT) {
+		throw std::logic_error("Error space for value");
+	}
+	writer_->String(value);
+	if (slots_.back() == Slot::VALUE) {
+		slots_.pop_back();
+	}
+	return BaseContext(*this);
+}
+
 Builder::DictItemContext Builder::StartDict()
 {	
+	if (writer_) {
+		if (slots_.empty()) {
+			throw std::logic_error("Object already done");
+		}
+		if (slots_.back() == Slot::DICT) {
+			throw std::logic_error("Wrong Dict context");
+		}
+		writer_->StartDict();
+		if (slots_.back() == Slot::VALUE) {
+			slots_.back() = Slot::DICT;
+		}
+		else {
+			slots_.push_back(Slot::DICT);
+		}
+		return BaseContext(*this);
+	}
 	if (nodes_stack_.empty()) {
 		throw std::logic_error("Object already done");
 	}
@@ -57,6 +120,22 @@ Builder::DictItemContext Builder::StartDict()
 
 Builder::ArrayItemContext Builder::StartArray()
 {
+	if (writer_) {
+		if (slots_.empty()) {
+			throw std::logic_error("Object already done");
+		}
+		if (slots_.back() == Slot::DICT) {
+			throw std::logic_error("Wrong Array context");
+		}
+		writer_->StartArray();
+		if (slots_.back() == Slot::VALUE) {
+			slots_.back() = Slot::ARRAY;
+		}
+		else {
+			slots_.push_back(Slot::ARRAY);
+		}
+		return BaseContext(*this);
+	}
 	if (nodes_stack_.empty()) {
 		throw std::logic_error("Object already done");
 	}
@@ -74,6 +153,17 @@ Builder::ArrayItemContext Builder::StartArray()
 
 Builder::BaseContext Builder::EndDict()
 {
+	if (writer_) {
+		if (slots_.empty()) {
+			throw std::logic_error("Object already done");
+		}
+		if (slots_.back() != Slot::DICT) {
+			throw std::logic_error("Wrong Dict context");
+		}
+		writer_->EndDict();
+		slots_.pop_back();
+		return *this;
+	}
 	if (nodes_stack_.empty()) {
 		throw std::logic_error("Object already done");
 	}
@@ -86,6 +176,17 @@ Builder::BaseContext Builder::EndDict()
 
 Builder::BaseContext Builder::EndArray()
 {
+	if (writer_) {
+		if (slots_.empty()) {
+			throw std::logic_error("Object already done");
+		}
+		if (slots_.back() != Slot::ARRAY) {
+			throw std::logic_error("Wrong Array context");
+		}
+		writer_->EndArray();
+		slots_.pop_back();
+		return *this;
+	}
 	if (nodes_stack_.empty()) {
 		throw std::logic_error("Object already done");
 	}
@@ -98,12 +199,51 @@ Builder::BaseContext Builder::EndArray()
 
 Node Builder::Build()
 {
+	if (writer_) {
+		if (!slots_.empty()) {
+			throw std::logic_error("Object not ready to build");
+		}
+		slots_.push_back(Slot::VALUE);
+		return Node();
+	}
 	if (!nodes_stack_.empty()) {
 		throw std::logic_error("Object not ready to build");
 	}
 	return root_;
 }
 
+void Builder::Reset()
+{
+	if (writer_) {
+		slots_.assign(1, Slot::VALUE);
+		return;
+	}
+	root_ = nullptr;
+	nodes_stack_.assign(1, &root_);
+}
+
+void Builder::WriteValue(Node::Value value)
+{
+	if (auto* text = std::get_if<std::string>(&value)) {
+		writer_->String(*text);
+	}
+	else if (auto* number = std::get_if<int>(&value)) {
+		writer_->Int(*number);
+	}
+	else if (auto* number = std::get_if<double>(&value)) {
+		writer_->Double(*number);
+	}
+	else if (auto* flag = std::get_if<bool>(&value)) {
+		writer_->Bool(*flag);
+	}
+	else {
+		// Готовые массивы и словари, а также null
+		Node node;
+		node.GetValue() = std::move(value);
+		writer_->Value(node);
+	}
+}
+
 //-------------------------BaseContext------------------------------------
 
 Builder::BaseContext::BaseContext(Builder& builder):builder_(builder){
@@ -114,9 +254,9 @@ Node Builder::BaseContext::Build()
 	return builder_.Build();
 }
 
-Builder::DictValueContext Builder::BaseContext::Key(std::string key)
+Builder::DictValueContext Builder::BaseContext::Key(std::string_view key)
 {
-	return builder_.Key(std::move(key));
+	return builder_.Key(key);
 }
 
 Builder::BaseContext Builder::BaseContext::Value(Node::Value value)
@@ -1,4 +1,7 @@
 #include "json.h"
+#include "json_writer.h"
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace json {
@@ -8,26 +11,56 @@ class Builder
 	class DictValueContext;
 	class DictItemContext;
 	class ArrayItemContext;
+	// Строки, литералы и представления строк
+	template <typename String>
+	using IfString = std::enable_if_t<std::is_convertible_v<const String&, std::string_view>, int>;
 public:
 	Builder();
-	DictValueContext Key(std::string key);
+	// Режим прямой записи: значения сразу уходят в writer, узлы не создаются.
+	// Ключи словаря выводятся в порядке вызовов, а не по алфавиту. Build()
+	// проверяет, что значение завершено, возвращает пустой узел и готовит
+	// Builder к записи следующего значения.
+	explicit Builder(ValueWriter& writer);
+	// Ключи и строки передаются представлением: в режиме записи они уходят
+	// в writer без промежуточного std::string
+	DictValueContext Key(std::string_view key);
 	BaseContext Value(Node::Value value);
+	template <typename String, IfString<String> = 0>
+	BaseContext Value(const String& value);
 	DictItemContext StartDict();
 	ArrayItemContext StartArray();
 	BaseContext EndDict();
 	BaseContext EndArray();
 	Node Build();
+	// Забывает недостроенное значение, например после исключения
+	void Reset();
 
 private:
+	// Открытые элементы в режиме записи, в том же порядке, что nodes_stack_
+	enum class Slot {
+		VALUE,
+		DICT,
+		ARRAY,
+	};
+
+	BaseContext StringValue(std::string_view value);
+	void WriteValue(Node::Value value);
+
 	Node root_;
 	std::vector <Node*> nodes_stack_;
+	ValueWriter* writer_ = nullptr;
+	std::vector<Slot> slots_;
 
 	class BaseContext {
 	public:
 		BaseContext(Builder& builder);
 		Node Build();
-		DictValueContext Key(std::string key);
+		DictValueContext Key(std::string_view key);
 		BaseContext Value(Node::Value value);
+		template <typename String, IfString<String> = 0>
+		BaseContext Value(const String& value) {
+			return builder_.StringValue(value);
+		}
 		DictItemContext StartDict();
 		ArrayItemContext StartArray();
 		BaseContext EndDict();
@@ -52,9 +85,13 @@ private:
 		DictValueContext(BaseContext base);
 		Node Build() = delete;
 		DictItemContext Value(Node::Value value);
+		template <typename String, IfString<String> = 0>
+		DictItemContext Value(const String& value) {
+			return BaseContext(*this).Value(value);
+		}
 		BaseContext EndArray() = delete;
 		BaseContext EndDict() = delete;
-		DictValueContext Key(std::string key) = delete;
+		DictValueContext Key(std::string_view key) = delete;
 	};
 
 
@@ -63,9 +100,18 @@ private:
 		ArrayItemContext(BaseContext base);
 		Node Build() = delete;
 		ArrayItemContext Value(Node::Value value);
+		template <typename String, IfString<String> = 0>
+		ArrayItemContext Value(const String& value) {
+			return BaseContext(*this).Value(value);
+		}
 		BaseContext EndDict() = delete;
-		DictValueContext Key(std::string key)=delete;
+		DictValueContext Key(std::string_view key)=delete;
 	};
 
 };
+
+template <typename String, Builder::IfString<String>>
+Builder::BaseContext Builder::Value(const String& value) {
+	return StringValue(value);
+}
 }
\ No newline at end of file
@@ -1,7 +1,161 @@
 #include "json_reader.h"
+#include "json_writer.h"
+#include "cbor.h"
+#include <algorithm>
+#include <deque>
 #include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 
-JSONReader::JSONReader(catalogue::TransportCatalogue& catalogue):catalogue_(catalogue){
+namespace {
+// Меньшие объёмы быстрее обработать в одном потоке, чем запускать рабочие
+const size_t MIN_ITEMS_PER_THREAD = 1024;
+const size_t MIN_BYTES_PER_THREAD = 1 << 20;
+// Части массивов для параллельного разбора: мельче, чем на поток, чтобы
+// поровну распределить их между потоками
+const size_t ARRAY_PART_SIZE = 256 * 1024;
+
+// Ограничения потокового режима: память на запрос не зависит от входа
+const size_t MAX_REQUEST_SIZE = 1 << 20;
+const size_t RESPONSE_BUFFER_SIZE = 64 * 1024;
+
+enum class LineStatus {
+    OK,
+    TOO_LONG,
+    END,
+};
+
+// Читает строку до '\n', сохраняя не больше max_size символов: остаток
+// слишком длинной строки пропускается
+LineStatus ReadLine(std::istream& input, std::string& line, size_t max_size) {
+    using Traits = std::char_traits<char>;
+    line.clear();
+    std::streambuf* buffer = input.rdbuf();
+    if (buffer == nullptr) {
+        return LineStatus::END;
+    }
+    bool is_empty = true;
+    bool too_long = false;
+    for (Traits::int_type c = buffer->sbumpc(); !Traits::eq_int_type(c, Traits::eof()); c = buffer->sbumpc()) {
+        is_empty = false;
+        if (c == '\n') {
+            break;
+        }
+        if (line.size() < max_size) {
+            line.push_back(Traits::to_char_type(c));
+        }
+        else {
+            too_long = true;
+        }
+    }
+    if (is_empty) {
+        return LineStatus::END;
+    }
+    return too_long ? LineStatus::TOO_LONG : LineStatus::OK;
+}
+
+// Номер запроса из строки, которую схема не распознала или не разобрала
+std::optional<int> FindRequestId(std::string_view line) {
+    json::NodeHandler handler;
+    try {
+        json::Parse(line, handler);
+    }
+    catch (const json::ParsingError&) {
+        return std::nullopt;
+    }
+    const json::Node request = handler.Extract();
+    if (!request.IsMap()) {
+        return std::nullopt;
+    }
+    const auto it = request.AsMap().find("id");
+    if (it == request.AsMap().end() || !it->second.IsInt()) {
+        return std::nullopt;
+    }
+    return it->second.AsInt();
+}
+
+// Текст ответа с ошибкой. Сообщения поиска из стандартной библиотеки вроде
+// "unordered_map::at" клиенту ничего не говорят и зависят от реализации.
+std::string ErrorMessage(const std::exception& e) {
+    if (dynamic_cast<const std::out_of_range*>(&e)) {
+        return "not found";
+    }
+    return e.what();
+}
+
+template <typename Func>
+void ParallelFor(size_t count, size_t threads, Func func) {
+    threads = std::min(threads, count / MIN_ITEMS_PER_THREAD);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+    const size_t chunk = (count + threads - 1) / threads;
+    std::vector<std::future<void>> tasks;
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        const size_t end = std::min(count, begin + chunk);
+        tasks.push_back(std::async(std::launch::async, [&func, begin, end] {
+            for (size_t i = begin; i < end; ++i) {
+                func(i);
+            }
+        }));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
+// Разбирает части массива, найденные Sections, в threads потоках: каждый
+// поток разбирает подряд идущие части своим обработчиком, первый — main,
+// остальные — Handler(args...). Результаты присоединяются к main в порядке
+// входных данных.
+template <typename Handler, typename... Args>
+void ParseParallel(const std::vector<std::string_view>& parts, size_t threads, Handler& main, Args&&... args) {
+    threads = std::max<size_t>(1, std::min(threads, parts.size()));
+    const auto parse_group = [&parts, threads](size_t group, Handler& handler) {
+        for (size_t i = group * parts.size() / threads; i < (group + 1) * parts.size() / threads; ++i) {
+            json::ParseArrayPart(parts[i], handler);
+        }
+    };
+    // Обработчики не перемещаются, пока их заполняют рабочие потоки
+    std::deque<Handler> handlers;
+    std::vector<std::future<void>> tasks;
+    for (size_t group = 1; group < threads; ++group) {
+        Handler& handler = handlers.emplace_back(args...);
+        tasks.push_back(std::async(std::launch::async, [&parse_group, group, &handler] {
+            parse_group(group, handler);
+        }));
+    }
+    parse_group(0, main);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        tasks[i].get();
+        main.Append(std::move(handlers[i]));
+    }
+}
+}
+
+JSONReader::JSONReader(catalogue::TransportCatalogue& catalogue)
+    :ingest_threads_(std::max(1u, std::thread::hardware_concurrency())), catalogue_(catalogue){
+}
+
+void JSONReader::SetIngestThreads(size_t threads) {
+    ingest_threads_ = std::max<size_t>(1, threads);
+}
+
+void JSONReader::SetInputFormat(DataFormat format) {
+    input_format_ = format;
+}
+
+void JSONReader::SetOutputFormat(DataFormat format) {
+    output_format_ = format;
+}
+
+void JSONReader::SetMapFile(std::string path) {
+    map_file_ = std::move(path);
 }
 
 json::Document JSONReader::LoadJSON(const std::string& s) {
@@ -10,9 +164,214 @@ json::Document JSONReader::LoadJSON(const std::string& s) {
 }
 
 void JSONReader::BaseRequest(catalogue::TransportCatalogue& catalogue, std::istream& input, std::ostream& output) {
-    json::Document command = json::Load(input);
-    ApplyCommands(command, catalogue);
-    ParseAndPrintStat(command, catalogue, output);
+    const std::string text = json::ReadAll(input);
+    ProcessCommands(text, catalogue, output);
+}
+
+void JSONReader::BaseRequestFromFile(catalogue::TransportCatalogue& catalogue, const std::string& path, std::ostream& output) {
+    const json::MappedFile file(path);
+    ProcessCommands(file.GetText(), catalogue, output);
+}
+
+void JSONReader::ServeRequests(const std::string& path, std::istream& input, std::ostream& output) {
+    catalogue::VersionedCatalogue versions;
+    PublishVersion(path, versions);
+    // Каждая строка обслуживается одной версией, даже если во время её
+    // обработки выйдет новая. Настройки переключаются вместе с версией.
+    std::shared_ptr<const catalogue::CatalogueVersion> version;
+    std::optional<SettingsScope> settings;
+
+    requests::StatRequestsHandler handler(requests::StatRequestsHandler::Root::REQUEST);
+    std::string line;
+    // Ответ на строку копится в буфере writer и уходит в output, только если записан целиком
+    json::Writer writer(output, 0, json::Writer::Layout::ONE_LINE);
+    json::Builder builder(writer);
+    // Строки в output выводит и поток перезагрузки
+    std::mutex output_mutex;
+    std::future<void> reload;
+    for (LineStatus status; (status = ReadLine(input, line, MAX_REQUEST_SIZE)) != LineStatus::END;) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos && status == LineStatus::OK) {
+            continue;
+        }
+        if (auto current = versions.Acquire(); current != version) {
+            version = std::move(current);
+            settings.emplace(*this, version->GetSettings());
+        }
+        StatOutput out{ version->GetCatalogue(), writer, builder, version.get() };
+        std::optional<int> request_id;
+        try {
+            if (status == LineStatus::TOO_LONG) {
+                WriteError(builder, "Request is too long");
+            }
+            else {
+                handler.Clear();
+                json::Parse(line, handler);
+                const std::vector<requests::StatRequest> requests = handler.Extract();
+                if (requests.empty()) {
+                    // Запрос неизвестного типа тоже получает свою строку ответа
+                    WriteError(builder, "Unknown request type", FindRequestId(line));
+                }
+                for (const auto& request : requests) {
+                    if (const auto* typed = std::get_if<requests::ReloadRequest>(&request)) {
+                        request_id = typed->id;
+                        if (reload.valid() && reload.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                            throw std::logic_error("Reload in progress");
+                        }
+                        // Новая версия строится в стороне, запросы тем временем обслуживает текущая
+                        reload = std::async(std::launch::async, [this, &path, &versions, &output, &output_mutex, id = typed->id] {
+                            Reload(path, id, versions, output, output_mutex);
+                            });
+                        continue;
+                    }
+                    std::visit([this, &out, &request_id](const auto& typed) {
+                        request_id = typed.id;
+                        PrintStat(typed, out);
+                        }, request);
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            // Недописанный ответ отбрасывается, ошибка не останавливает поток
+            writer.Reset();
+            builder.Reset();
+            if (!request_id && status == LineStatus::OK) {
+                request_id = FindRequestId(line);
+            }
+            WriteError(builder, ErrorMessage(e), request_id);
+        }
+        std::lock_guard guard(output_mutex);
+        writer.Flush();
+        // Ответ уходит сразу, не дожидаясь следующих строк
+        output.flush();
+    }
+    // Ответ на начатую перезагрузку тоже должен попасть в output
+    if (reload.valid()) {
+        reload.wait();
+    }
+}
+
+uint64_t JSONReader::PublishVersion(const std::string& path, catalogue::VersionedCatalogue& versions) const {
+    const json::MappedFile file(path);
+    auto db = std::make_unique<catalogue::TransportCatalogue>();
+    const json::Sections sections = LoadSections(file.GetText(), *db, nullptr);
+    if (!sections.IsMap()) {
+        throw std::logic_error("Not map");
+    }
+    // Настройки разбираются сразу: версия не должна ссылаться на текст файла
+    json::Dict settings;
+    for (const std::string key : { "render_settings", "routing_settings" }) {
+        if (const std::string_view* text = sections.Find(key)) {
+            settings.emplace(key, ParseSection(*text));
+        }
+    }
+    return versions.Publish(std::move(db), std::move(settings));
+}
+
+void JSONReader::Reload(const std::string& path, int request_id, catalogue::VersionedCatalogue& versions,
+    std::ostream& output, std::mutex& output_mutex) {
+    std::ostringstream line;
+    json::Writer writer(line, 0, json::Writer::Layout::ONE_LINE);
+    json::Builder builder(writer);
+    try {
+        const uint64_t number = PublishVersion(path, versions);
+        builder.StartDict().Key("request_id").Value(request_id).Key("version").Value(static_cast<int>(number)).EndDict().Build();
+    }
+    catch (const std::exception& e) {
+        // Прежняя версия остаётся в силе
+        writer.Reset();
+        builder.Reset();
+        WriteError(builder, ErrorMessage(e), request_id);
+    }
+    writer.Flush();
+    std::lock_guard guard(output_mutex);
+    output << line.str();
+    output.flush();
+}
+
+json::Sections JSONReader::LoadSections(std::string_view text, catalogue::TransportCatalogue& catalogue,
+    requests::StatRequestsHandler* stat_requests) const {
+    using namespace std::literals;
+    BaseRequestsHandler base_requests(catalogue);
+    bool has_base_requests = false;
+    bool has_stat_requests = false;
+    // Большой документ JSON размечается целиком, а затем массивы запросов
+    // разбираются по частям в нескольких потоках
+    const bool is_parallel = input_format_ == DataFormat::JSON && ingest_threads_ > 1
+        && text.size() >= 2 * MIN_BYTES_PER_THREAD;
+    // Иначе запросы разбираются за тот же проход, что размечает разделы; как
+    // и в словаре, из повторяющихся разделов учитывается первый
+    const json::Sections::Selector select = [&](std::string_view key) -> json::Handler* {
+        if (is_parallel) {
+            return nullptr;
+        }
+        if (key == "base_requests"sv && !has_base_requests) {
+            has_base_requests = true;
+            return &base_requests;
+        }
+        if (key == "stat_requests"sv && stat_requests && !has_stat_requests) {
+            has_stat_requests = true;
+            return stat_requests;
+        }
+        return nullptr;
+    };
+    json::Sections sections = input_format_ == DataFormat::CBOR
+        ? cbor::SplitSections(text, select)
+        : json::Sections(text, select, is_parallel ? ARRAY_PART_SIZE : 0);
+    if (is_parallel) {
+        const size_t threads = std::min(ingest_threads_, text.size() / MIN_BYTES_PER_THREAD);
+        // Раздел, который не массив, разбирается целиком: обработчик сообщит об ошибке
+        const auto parse = [&sections, threads](const std::string& key, auto& handler, auto&&... args) {
+            if (const std::vector<std::string_view>* parts = sections.FindParts(key)) {
+                ParseParallel(*parts, threads, handler, args...);
+            }
+            else if (const std::string_view* section = sections.Find(key)) {
+                json::Parse(*section, handler);
+            }
+        };
+        parse("base_requests", base_requests, catalogue, BaseRequestsHandler::Mode::DEFERRED);
+        if (stat_requests) {
+            parse("stat_requests", *stat_requests);
+        }
+    }
+    base_requests.Finish(ingest_threads_);
+    return sections;
+}
+
+JSONReader::SettingsScope::SettingsScope(JSONReader& reader, const json::Sections& sections) :reader_(reader) {
+    reader_.ResetSettings();
+    reader_.sections_ = &sections;
+}
+
+JSONReader::SettingsScope::SettingsScope(JSONReader& reader, const json::Dict& commands) :reader_(reader) {
+    reader_.ResetSettings();
+    reader_.commands_ = &commands;
+}
+
+JSONReader::SettingsScope::~SettingsScope() {
+    reader_.ResetSettings();
+}
+
+void JSONReader::ResetSettings() {
+    commands_ = nullptr;
+    sections_ = nullptr;
+    parsed_sections_.clear();
+    router_ready_ = false;
+}
+
+void JSONReader::ProcessCommands(std::string_view text, catalogue::TransportCatalogue& catalogue, std::ostream& output) {
+    // Строки запросов хранятся в обработчике, он живёт до конца ответа
+    requests::StatRequestsHandler stat_requests;
+    const json::Sections sections = LoadSections(text, catalogue, &stat_requests);
+    if (!sections.IsMap()) {
+        return;
+    }
+    if (!sections.Find("stat_requests")) {
+        throw std::out_of_range("No key stat_requests");
+    }
+    catalogue.Freeze();
+    // Текст разделов живёт только во время обработки
+    const SettingsScope settings(*this, sections);
+    ParseAndPrintStat(stat_requests.Extract(), catalogue, output);
 }
 
 std::string JSONReader::Print(const json::Node& node) {
@@ -30,214 +389,494 @@ std::vector<geo::Coordinates> GetVectorOfCoordinates(const std::vector<catalogue
     return result;
 }
 
-std::vector<geo::Coordinates> AllCoordinates(std::set<std::string> stops, const catalogue::TransportCatalogue& catalogue) {
+std::vector<geo::Coordinates> AllCoordinates(const std::set<std::string_view>& stops, const catalogue::TransportCatalogue& catalogue) {
     std::vector<geo::Coordinates> result;
     for (const auto& stop : stops) {
-        if(!catalogue.GetStopInfo(stop).empty())
-        result.push_back(geo::Coordinates{ catalogue.FindStop(stop)->latitude, catalogue.FindStop(stop)->longitude });
+        const auto* stop_ptr = catalogue.FindStop(stop);
+        if(!catalogue.GetBusesByStop(stop_ptr).empty())
+        result.push_back(geo::Coordinates{ stop_ptr->latitude, stop_ptr->longitude });
     }
     return result;
 }
 
-void ApplyRenderSettings(json::Document& commands,const catalogue::TransportCatalogue& catalogue, std::ostream& out) {
+void ApplyRenderSettings(const json::Dict& render_settings, const catalogue::TransportCatalogue& catalogue, std::ostream& out) {
     renderer::MapRenderer map_renderer;
-    map_renderer.FillRenderSettings(commands.GetRoot().AsMap().at("render_settings").AsMap());
+    map_renderer.FillRenderSettings(render_settings);
     svg::Document map;
     std::vector<svg::Text> bus_label, stop_label;
-    std::map<std::string, bool> buses;
-    std::set<std::string> stops;
-    const auto& com = commands.GetRoot().AsMap().at("base_requests").AsArray();
-    for (const auto& info : com) {
-        if (info.AsMap().at("type").AsString() == "Bus") {
-            buses.insert({ info.AsMap().at("name").AsString(), info.AsMap().at("is_roundtrip").AsBool() });
-        }
-        else if (info.AsMap().at("type").AsString() == "Stop") {
-            stops.insert(info.AsMap().at("name").AsString());
-        }
+    std::set<std::string_view> buses;
+    std::set<std::string_view> stops;
+    for (const auto& bus : catalogue.GetAllBuses()) {
+        buses.insert(bus.name);
+    }
+    for (const auto& stop : catalogue.GetAllStops()) {
+        stops.insert(stop.name);
     }
     std::vector<geo::Coordinates> coordinates=AllCoordinates(stops,catalogue);
     const renderer::SphereProjector proj{ coordinates.begin(),coordinates.end(), map_renderer.GetRenderSettings().width, map_renderer.GetRenderSettings().height, map_renderer.GetRenderSettings().padding};
     int counter = 0;
     for (auto& bus : buses) {
-        map_renderer.FillMap(catalogue.FindBus(bus.first), map,proj, counter, bus.second, bus_label);
+        map_renderer.FillMap(catalogue.FindBus(bus), map,proj, counter, bus_label);
     }
     for (auto& bus : bus_label) {
         map.Add(bus);
     }
 
     for (auto& stop : stops) {
-        if (!catalogue.GetStopInfo(stop).empty()) {
-            map_renderer.FillStops(map, proj, catalogue.FindStop(stop), stop_label);
+        const auto* stop_ptr = catalogue.FindStop(stop);
+        if (!catalogue.GetBusesByStop(stop_ptr).empty()) {
+            map_renderer.FillStops(map, proj, stop_ptr, stop_label);
         }
     }
     for (auto& stop : stop_label) {
         map.Add(stop);
     }
-    std::ofstream fout("hello.svg");
-    map.Render(fout);
-    fout.close();
     map.Render(out);
 }
 
 
 
-std::unordered_map < std::string_view, int> JSONReader::ParseDistances(const json::Dict& stops) {
-    std::unordered_map<std::string_view, int> result;
-    for (const auto& stop : stops) {
-        result.emplace(stop.first, stop.second.AsInt());
+std::vector<catalogue::detail::Stop*> JSONReader::ParseRoute(const json::Array& route, catalogue::TransportCatalogue& catalogue) {
+    std::vector<catalogue::detail::Stop*> result;
+    result.reserve(route.size());
+    for (const auto& stop : route) {
+        result.push_back(catalogue.FindStop(stop.AsString()));
     }
     return result;
 }
 
-std::vector<std::string_view> JSONReader::ParseRoute(const json::Array& route, const bool& is_roundtrip) {
-    std::vector<std::string_view> result;
-    for (const auto& stop : route) {
-        result.push_back(stop.AsString());
+void JSONReader::FillCatalogue(const json::Array& base_requests, catalogue::TransportCatalogue& catalogue) {
+    using catalogue::detail::Stop;
+    std::vector<const json::Dict*> stops;
+    std::vector<const json::Dict*> buses;
+    for (const auto& info : base_requests) {
+        const auto& request = info.AsMap();
+        const requests::Type type = requests::FindType(request.at("type").AsString());
+        if (type == requests::Type::STOP) {
+            stops.push_back(&request);
+            catalogue.AddStop(request.at("name").AsString(), geo::Coordinates{ request.at("latitude").AsDouble(), request.at("longitude").AsDouble() });
+        }
+        else if (type == requests::Type::BUS) {
+            buses.push_back(&request);
+        }
     }
-    if (!is_roundtrip) {
-        for (size_t i = (route.size() - 2); i > 0; i--) {
-            result.push_back(route[i].AsString());
+
+    for (const json::Dict* stop : stops) {
+        Stop* from = catalogue.FindStop(stop->at("name").AsString());
+        for (const auto& [name, distance] : stop->at("road_distances").AsMap()) {
+            catalogue.AddStopDistance(from, catalogue.FindStop(name), distance.AsInt());
         }
-        result.push_back(route[0].AsString());
     }
-    return result;
+    for (const json::Dict* bus : buses) {
+        catalogue.AddBus(bus->at("name").AsString(), ParseRoute(bus->at("stops").AsArray(), catalogue), bus->at("is_roundtrip").AsBool());
+    }
 }
 
 void JSONReader::ApplyCommands(json::Document& commands, catalogue::TransportCatalogue& catalogue) {
     if (!commands.GetRoot().IsMap()) {
         return;
     }
-    std::unordered_map<std::string, json::Dict> stop_distances;
-    json::Array buses;
-    json::Array stops;
-    const auto& com = commands.GetRoot().AsMap().at("base_requests").AsArray();
-    for (const auto& info : com) {
-        if (info.AsMap().at("type").AsString() == "Stop") {
-            stop_distances[info.AsMap().at("name").AsString()] = info.AsMap().at("road_distances").AsMap();
-            stops.push_back(info.AsMap().at("name").AsString());
-            catalogue.AddStop(info.AsMap().at("name").AsString(), geo::Coordinates{ info.AsMap().at("latitude").AsDouble(), info.AsMap().at("longitude").AsDouble() });
-        }
-        else if (info.AsMap().at("type").AsString() == "Bus") {
-            buses.push_back(info);
+    FillCatalogue(commands.GetRoot().AsMap().at("base_requests").AsArray(), catalogue);
+    ApplySettings(commands, catalogue);
+}
+
+void JSONReader::ApplySettings(json::Document& commands, catalogue::TransportCatalogue& catalogue) {
+    catalogue.Freeze();
+    ResetSettings();
+    commands_ = &commands.GetRoot().AsMap();
+}
+
+const json::Node& JSONReader::GetSection(const std::string& key) {
+    // Отсутствие раздела — ошибка документа, а не ненайденное имя
+    if (commands_) {
+        if (const auto it = commands_->find(key); it != commands_->end()) {
+            return it->second;
         }
+        throw std::logic_error("No key " + key);
+    }
+    if (const auto it = parsed_sections_.find(key); it != parsed_sections_.end()) {
+        return it->second;
+    }
+    const std::string_view* text = sections_ ? sections_->Find(key) : nullptr;
+    if (!text) {
+        throw std::logic_error("No key " + key);
+    }
+    return parsed_sections_.emplace(key, ParseSection(*text)).first->second;
+}
+
+json::Node JSONReader::ParseSection(std::string_view text) const {
+    json::NodeHandler handler;
+    if (input_format_ == DataFormat::CBOR) {
+        cbor::Parse(text, handler);
+    }
+    else {
+        json::Parse(text, handler);
     }
+    return handler.Extract();
+}
 
-    for (const auto& stop : stop_distances) {
-        catalogue.AddStopDistances(stop.first, ParseDistances(stop.second));
+const std::string& JSONReader::GetMap(const catalogue::TransportCatalogue& catalogue, const json::ValueWriter& writer) {
+    const json::Dict& render_settings = GetSection("render_settings").AsMap();
+    const std::type_index encoding(typeid(writer));
+    if (map_cache_ && map_cache_->catalogue_version == catalogue.GetVersion()
+        && map_cache_->encoding == encoding && map_cache_->render_settings == render_settings) {
+        return map_cache_->encoded_svg;
     }
+    std::ostringstream svg;
+    ApplyRenderSettings(render_settings, catalogue, svg);
+    const std::string text = svg.str();
+    if (!map_file_.empty()) {
+        std::ofstream fout(map_file_);
+        fout << text;
+    }
+    map_cache_ = MapCache{ catalogue.GetVersion(), render_settings, encoding, writer.EncodeString(text) };
+    return map_cache_->encoded_svg;
+}
 
-    for (const auto& bus : buses) {
-        catalogue.AddBus(bus.AsMap().at("name").AsString(), ParseRoute(bus.AsMap().at("stops").AsArray(), bus.AsMap().at("is_roundtrip").AsBool()));
+void JSONReader::PrepareTransportRouter(const catalogue::TransportCatalogue& catalogue) {
+    if (router_ready_) {
+        return;
     }
+    transport_router_.FillRoutingSettings(GetSection("routing_settings").AsMap());
+    transport_router_.ConstructGraph(catalogue);
+    router_ready_ = true;
+}
 
-    const auto& rooting_settings = commands.GetRoot().AsMap().at("routing_settings").AsMap();
-    transport_router_.SetVelocity(rooting_settings.at("bus_velocity").AsDouble());
-    transport_router_.SetWaitTime(rooting_settings.at("bus_wait_time").AsInt());
 
-    transport_router_.ConstructGraph(catalogue, stops);
+// Ответы пишутся через json::Builder сразу в поток, поэтому ключи каждого
+// словаря перечисляются по алфавиту, как их выводил бы json::Dict.
 
+void JSONReader::WriteBuses(json::Builder& builder, catalogue::TransportCatalogue::BusesRange buses) {
+    builder.StartArray();
+    for (const auto* bus : buses) {
+        builder.Value(bus->name);
+    }
+    builder.EndArray();
 }
 
+void JSONReader::WriteStopDistances(json::Builder& builder, const std::vector<catalogue::detail::StopDistance>& stops) {
+    builder.StartArray();
+    for (const auto& [stop, distance] : stops) {
+        builder.StartDict().Key("distance").Value(distance).Key("name").Value(stop->name).EndDict();
+    }
+    builder.EndArray();
+}
 
-json::Array JSONReader::SetToArray(std::set<std::string_view> original) {
-    json::Array result;
-    for (auto& element : original) {
-        result.push_back(std::string(element));
+void JSONReader::WriteSuggestions(json::Builder& builder, const std::vector<catalogue::detail::NameSuggestion>& names) {
+    using namespace std::literals;
+    builder.StartArray();
+    for (const auto& [name, is_bus] : names) {
+        builder.StartDict().Key("name").Value(name).Key("type").Value(is_bus ? "Bus"sv : "Stop"sv).EndDict();
     }
-    return result;
+    builder.EndArray();
 }
 
-json::Dict JSONReader::PrintGraph(const json::Node& req)
+void JSONReader::WriteError(json::Builder& builder, std::string message, std::optional<int> request_id) {
+    using namespace std::literals;
+    auto dict = builder.StartDict().Key("error_message").Value(std::move(message));
+    if (request_id) {
+        dict.Key("request_id").Value(*request_id);
+    }
+    dict.EndDict().Build();
+}
+
+void JSONReader::WriteNotFound(json::Builder& builder, int request_id) {
+    using namespace std::literals;
+    builder.StartDict().Key("error_message").Value("not found").Key("request_id").Value(request_id).EndDict().Build();
+}
+
+void JSONReader::PrintGraph(const requests::RouteRequest& request, const TransportRouter& router, json::Builder& builder)
 {
     using namespace std::literals;
-    std::string from = req.AsMap().at("from").AsString();
-    std::string to = req.AsMap().at("to").AsString();
-    std::unordered_map<std::string, std::pair<size_t, size_t>> stops_edges = transport_router_.GetStopEdges();
-    if (from == to) {
-        return json::Builder{}.StartDict().Key("total_time").Value(0).Key("request_id").Value(req.AsMap().at("id").AsInt()).Key("items").StartArray().EndArray().EndDict().Build().AsMap();
+    const int request_id = request.id;
+    const auto& stops_edges = router.GetStopEdges();
+    if (request.from == request.to) {
+        builder.StartDict().Key("items").StartArray().EndArray().Key("request_id").Value(request_id).Key("total_time").Value(0).EndDict().Build();
+        return;
     }
-    else {
-        const auto info = transport_router_.GetRouter()->BuildRoute(stops_edges.at(from).first, stops_edges.at(to).first);
-        if (info.has_value()) {
-            const std::vector<graph::EdgeId>& elem = info.value().edges;
-            json::Array rout_arr;
-
-            double total_time = 0.0;
-            for (const graph::EdgeId& el : elem) {
-                json::Dict item_map;
-                const graph::Edge<double> edge = transport_router_.GetGraph().GetEdge(el);
-                if (edge.bus.empty()) {
-                    item_map["type"] = "Wait"s;
-                    item_map["stop_name"] = edge.stop;
-                    item_map["time"] = edge.weight;
-
-                    rout_arr.push_back(item_map);
-                }
-                else {
-                    item_map["type"] = "Bus"s;
-                    item_map["bus"] = edge.bus;
-                    item_map["span_count"] = edge.span_count;
-                    item_map["time"] = edge.weight;
-                    rout_arr.push_back(item_map);
-                }
-                total_time += edge.weight;
-            }
-            return json::Builder{}
-                .StartDict()
-                .Key("total_time").Value(total_time)
-                .Key("request_id").Value(req.AsMap().at("id").AsInt()).Key("items").Value(rout_arr)
-                .EndDict()
-                .Build()
-                .AsMap();
-        }
-        
-    }
-    return
-        json::Builder{}
-        .StartDict()
-        .Key("request_id").Value(req.AsMap().at("id").AsInt())
-        .Key("error_message").Value("not found")
+    const auto info = router.GetRouter()->BuildRoute(stops_edges.at(request.from).first, stops_edges.at(request.to).first);
+    if (!info.has_value()) {
+        WriteNotFound(builder, request_id);
+        return;
+    }
+    auto items = builder.StartDict().Key("items").StartArray();
+    double total_time = 0.0;
+    for (const graph::EdgeId& el : info.value().edges) {
+        const graph::Edge<double>& edge = router.GetGraph().GetEdge(el);
+        if (edge.bus.empty()) {
+            items.StartDict()
+                .Key("stop_name").Value(edge.stop)
+                .Key("time").Value(edge.weight)
+                .Key("type").Value("Wait")
+                .EndDict();
+        }
+        else {
+            items.StartDict()
+                .Key("bus").Value(edge.bus)
+                .Key("span_count").Value(edge.span_count)
+                .Key("time").Value(edge.weight)
+                .Key("type").Value("Bus")
+                .EndDict();
+        }
+        total_time += edge.weight;
+    }
+    items.EndArray()
+        .Key("request_id").Value(request_id)
+        .Key("total_time").Value(total_time)
         .EndDict()
-        .Build()
-        .AsMap();
+        .Build();
 }
 
-void JSONReader::ParseAndPrintStat(json::Document& commands, const catalogue::TransportCatalogue& catalogue, std::ostream& output) {
+void JSONReader::PrintStat(const requests::BusRequest& request, StatOutput& out) {
     using namespace std::literals;
+    if (!out.catalogue.FindBus(request.name)) {
+        WriteNotFound(out.builder, request.id);
+        return;
+    }
+    auto [all_stops, unique_stops, actual_distance, curvature] = out.catalogue.GetBusInfo(request.name);
+    out.builder.StartDict().Key("curvature").Value(curvature).Key("request_id").Value(request.id).Key("route_length")
+        .Value(actual_distance).Key("stop_count").Value(all_stops).Key("unique_stop_count").Value(unique_stops).EndDict().Build();
+}
+
+void JSONReader::PrintStat(const requests::StopRequest& request, StatOutput& out) {
+    using namespace std::literals;
+    const auto* stop = out.catalogue.FindStop(request.name);
+    if (!stop) {
+        WriteNotFound(out.builder, request.id);
+        return;
+    }
+    out.builder.StartDict().Key("buses");
+    WriteBuses(out.builder, out.catalogue.GetBusesByStop(stop));
+    out.builder.Key("request_id").Value(request.id).EndDict().Build();
+}
+
+void JSONReader::PrintStat(const requests::MapRequest& request, StatOutput& out) {
+    using namespace std::literals;
+    out.writer.StartDict();
+    out.writer.Key("map"sv);
+    // Карта выводится как есть: экранирована один раз при построении
+    out.writer.Encoded(GetMap(out.catalogue, out.writer));
+    out.writer.Key("request_id"sv);
+    out.writer.Int(request.id);
+    out.writer.EndDict();
+}
+
+void JSONReader::PrintStat(const requests::RouteRequest& request, StatOutput& out) {
+    if (out.version) {
+        PrintGraph(request, out.version->GetRouter(), out.builder);
+        return;
+    }
+    PrepareTransportRouter(out.catalogue);
+    PrintGraph(request, transport_router_, out.builder);
+}
+
+void JSONReader::PrintStat(const requests::NearbyRequest& request, StatOutput& out) {
+    using namespace std::literals;
+    out.builder.StartDict().Key("request_id").Value(request.id).Key("stops");
+    WriteStopDistances(out.builder, out.catalogue.FindNearestStops(request.point, request.count));
+    out.builder.EndDict().Build();
+}
+
+void JSONReader::PrintStat(const requests::InRadiusRequest& request, StatOutput& out) {
+    using namespace std::literals;
+    out.builder.StartDict().Key("request_id").Value(request.id).Key("stops");
+    WriteStopDistances(out.builder, out.catalogue.FindStopsInRadius(request.point, request.radius));
+    out.builder.EndDict().Build();
+}
+
+void JSONReader::PrintStat(const requests::SuggestRequest& request, StatOutput& out) {
+    using namespace std::literals;
+    out.builder.StartDict().Key("items");
+    WriteSuggestions(out.builder, out.catalogue.SuggestNames(request.prefix, request.count));
+    out.builder.Key("request_id").Value(request.id).EndDict().Build();
+}
+
+void JSONReader::PrintStat(const requests::ReloadRequest& request, StatOutput& out) {
+    // Документу перечитывать нечего: он прочитан целиком
+    WriteError(out.builder, "Reload is supported only in streaming mode", request.id);
+}
+
+void JSONReader::ParseAndPrintStat(json::Document& commands, const catalogue::TransportCatalogue& catalogue, std::ostream& output) {
     if (!commands.GetRoot().IsMap()) {
         return;
     }
-    const auto& requests = commands.GetRoot().AsMap().at("stat_requests").AsArray();
-    json::Array all_stat;
-    for (const auto& req : requests) {
-        if (req.AsMap().at("type").AsString() == "Bus") {
-            if (!catalogue.FindBus(req.AsMap().at("name").AsString())) {
-                all_stat.push_back(json::Builder{}.StartDict().Key("request_id"s).Value(req.AsMap().at("id").AsInt()).Key("error_message"s).Value("not found"s).EndDict().Build());
-            }
-            else {
-                auto [all_stops, unique_stops, actual_distance, curvature] = catalogue.GetBusInfo(req.AsMap().at("name").AsString());
-                all_stat.push_back(json::Builder{}.StartDict().Key("curvature"s).Value(curvature).Key("request_id"s).Value(req.AsMap().at("id").AsInt()).Key("route_length"s)
-                    .Value(actual_distance).Key("stop_count"s).Value(all_stops).Key("unique_stop_count"s).Value(unique_stops).EndDict().Build());
-            }
-        }
-        else if (req.AsMap().at("type").AsString() == "Stop") {
-            if (!catalogue.FindStop(req.AsMap().at("name").AsString())) {
-                all_stat.push_back(json::Builder{}.StartDict().Key("request_id"s).Value(req.AsMap().at("id").AsInt()).Key("error_message"s).Value("not found"s).EndDict().Build());
-            }
-            else {
-                std::set<std::string_view> buses_for_stop = catalogue.GetStopInfo(req.AsMap().at("name").AsString());
-                json::Array ar = SetToArray(buses_for_stop);
-                all_stat.push_back(json::Builder{}.StartDict().Key("buses"s).Value(ar).Key("request_id"s).Value(req.AsMap().at("id").AsInt()).EndDict().Build());
-            }
+    const auto requests = requests::DecodeStatRequests(commands.GetRoot().AsMap().at("stat_requests").AsArray());
+    // Настройки каждого документа свои: маршрутизатор строится заново
+    const SettingsScope settings(*this, commands.GetRoot().AsMap());
+    ParseAndPrintStat(requests, catalogue, output);
+}
+
+void JSONReader::ParseAndPrintStat(const std::vector<requests::StatRequest>& requests,
+    const catalogue::TransportCatalogue& catalogue, std::ostream& output) {
+    // Ответы выводятся по мере готовности, не накапливаясь в памяти
+    std::unique_ptr<json::ValueWriter> writer;
+    if (output_format_ == DataFormat::CBOR) {
+        writer = std::make_unique<cbor::Writer>(output);
+    }
+    else {
+        writer = std::make_unique<json::Writer>(output);
+    }
+    json::Builder builder(*writer);
+    StatOutput out{ catalogue, *writer, builder };
+    writer->StartArray();
+    for (const auto& request : requests) {
+        std::visit([this, &out](const auto& typed) {
+            PrintStat(typed, out);
+            }, request);
+    }
+    writer->EndArray();
+}
+
+//-----------------------------BaseRequestsHandler----------------------------------
+
+BaseRequestsHandler::BaseRequestsHandler(catalogue::TransportCatalogue& catalogue, Mode mode)
+    :catalogue_(catalogue), mode_(mode) {
+}
+
+void BaseRequestsHandler::Null() {
+}
+
+void BaseRequestsHandler::Bool(bool value) {
+    if (depth_ == 2 && field_ == requests::Field::IS_ROUNDTRIP) {
+        request_.is_roundtrip = value;
+    }
+}
+
+void BaseRequestsHandler::Int(int value) {
+    if (depth_ == 3 && field_ == requests::Field::ROAD_DISTANCES) {
+        request_.distances.emplace_back(distance_key_, value);
+    }
+    else {
+        SetNumber(value);
+    }
+}
+
+void BaseRequestsHandler::Double(double value) {
+    if (depth_ == 3 && field_ == requests::Field::ROAD_DISTANCES) {
+        throw std::logic_error("Not int");
+    }
+    SetNumber(value);
+}
+
+void BaseRequestsHandler::SetNumber(double value) {
+    if (depth_ != 2) {
+        return;
+    }
+    if (field_ == requests::Field::LATITUDE) {
+        request_.latitude = value;
+    }
+    else if (field_ == requests::Field::LONGITUDE) {
+        request_.longitude = value;
+    }
+}
+
+void BaseRequestsHandler::String(std::string_view value) {
+    if (depth_ == 2 && field_ == requests::Field::TYPE) {
+        request_.type = requests::FindType(value);
+    }
+    else if (depth_ == 2 && field_ == requests::Field::NAME) {
+        request_.name = value;
+    }
+    else if (depth_ == 3 && field_ == requests::Field::STOPS) {
+        request_.stops.push_back(pending_names_.Add(value));
+    }
+}
+
+void BaseRequestsHandler::StartArray() {
+    ++depth_;
+}
+
+void BaseRequestsHandler::EndArray() {
+    --depth_;
+}
+
+void BaseRequestsHandler::StartDict() {
+    ++depth_;
+}
+
+void BaseRequestsHandler::Key(std::string_view key) {
+    if (depth_ == 3) {
+        distance_key_ = pending_names_.Add(key);
+        return;
+    }
+    if (depth_ != 2) {
+        return;
+    }
+    field_ = requests::FindField(key);
+}
+
+void BaseRequestsHandler::EndDict() {
+    --depth_;
+    if (depth_ == 1) {
+        EndRequest();
+    }
+}
+
+void BaseRequestsHandler::EndRequest() {
+    if (request_.type == requests::Type::STOP && mode_ == Mode::DEFERRED) {
+        stop_distances_.insert(stop_distances_.end(), request_.distances.begin(), request_.distances.end());
+        stops_.push_back({ pending_names_.Add(request_.name), geo::Coordinates{ request_.latitude, request_.longitude },
+            stop_distances_.size() });
+    }
+    else if (request_.type == requests::Type::STOP) {
+        catalogue_.AddStop(request_.name, geo::Coordinates{ request_.latitude, request_.longitude });
+        catalogue::detail::Stop* from = catalogue_.FindStop(request_.name);
+        for (const auto& [to, distance] : request_.distances) {
+            distances_.emplace_back(from, to, distance);
         }
-        else if (req.AsMap().at("type").AsString() == "Map") {
-            std::ostringstream map;
-            ApplyRenderSettings(commands, catalogue, map);
-            all_stat.push_back(json::Builder{}.StartDict().Key("map"s).Value(map.str()).Key("request_id"s).Value(req.AsMap().at("id").AsInt()).EndDict().Build());
+    }
+    else if (request_.type == requests::Type::BUS) {
+        buses_.push_back({ pending_names_.Add(request_.name), std::move(request_.stops), request_.is_roundtrip });
+    }
+    request_.type = requests::Type::UNKNOWN;
+    request_.name.clear();
+    request_.latitude = 0;
+    request_.longitude = 0;
+    request_.is_roundtrip = false;
+    request_.distances.clear();
+    request_.stops.clear();
+    field_ = requests::Field::UNKNOWN;
+}
+
+void BaseRequestsHandler::Append(BaseRequestsHandler&& part) {
+    size_t distance_index = 0;
+    for (const PendingStop& stop : part.stops_) {
+        catalogue_.AddStop(stop.name, stop.coordinates);
+        catalogue::detail::Stop* from = catalogue_.FindStop(stop.name);
+        for (; distance_index < stop.distances_end; ++distance_index) {
+            const auto& [to, distance] = part.stop_distances_[distance_index];
+            distances_.emplace_back(from, to, distance);
         }
-        else if (req.AsMap().at("type").AsString() == "Route") {
-            all_stat.push_back(PrintGraph(req));
+    }
+    buses_.insert(buses_.end(), std::make_move_iterator(part.buses_.begin()),
+        std::make_move_iterator(part.buses_.end()));
+    // Имена остановок, расстояний и маршрутов part остаются в её хранилище
+    pending_names_.Append(std::move(part.pending_names_));
+    part.stops_.clear();
+    part.stop_distances_.clear();
+    part.buses_.clear();
+}
+
+void BaseRequestsHandler::Finish(size_t threads) {
+    using catalogue::detail::Stop;
+    // Справочник здесь только читается, результаты добавляются по порядку
+    std::vector<Stop*> distance_stops(distances_.size());
+    ParallelFor(distances_.size(), threads, [this, &distance_stops](size_t i) {
+        distance_stops[i] = catalogue_.FindStop(std::get<1>(distances_[i]));
+    });
+    std::vector<std::vector<Stop*>> routes(buses_.size());
+    ParallelFor(buses_.size(), threads, [this, &routes](size_t i) {
+        routes[i].reserve(buses_[i].stops.size());
+        for (std::string_view stop : buses_[i].stops) {
+            routes[i].push_back(catalogue_.FindStop(stop));
         }
+    });
+    for (size_t i = 0; i < distances_.size(); ++i) {
+        catalogue_.AddStopDistance(std::get<0>(distances_[i]), distance_stops[i], std::get<2>(distances_[i]));
+    }
+    for (size_t i = 0; i < buses_.size(); ++i) {
+        catalogue_.AddBus(buses_[i].name, std::move(routes[i]), buses_[i].is_roundtrip);
     }
-    json::Print(json::Document{ json::Node{all_stat} }, output);
+    distances_.clear();
+    buses_.clear();
 }
@@ -1,28 +1,220 @@
 #pragma once
+#include <optional>
 #include <sstream>
+#include <typeindex>
 #include <unordered_set>
+#include "requests.h"
 #include "transport_router.h"
+#include "versioned_catalogue.h"
+
+// Заполняет справочник по событиям разбора массива base_requests, не строя
+// дерево документа. Расстояния и маршруты могут ссылаться на остановки,
+// описанные позже, поэтому они добавляются в Finish.
+class BaseRequestsHandler final : public json::Handler {
+public:
+	enum class Mode {
+		// Остановки добавляются в справочник по мере разбора
+		IMMEDIATE,
+		// Справочник не меняется до Append: так части массива можно
+		// разбирать в разных потоках
+		DEFERRED,
+	};
+
+	explicit BaseRequestsHandler(catalogue::TransportCatalogue& catalogue, Mode mode = Mode::IMMEDIATE);
+
+	void Null() override;
+	void Bool(bool value) override;
+	void Int(int value) override;
+	void Double(double value) override;
+	void String(std::string_view value) override;
+	void StartArray() override;
+	void EndArray() override;
+	void StartDict() override;
+	void Key(std::string_view key) override;
+	void EndDict() override;
+
+	// Добавляет остановки из part, разобранной в режиме DEFERRED из следующей
+	// части массива; расстояния и маршруты part откладываются до Finish
+	void Append(BaseRequestsHandler&& part);
+	// Добавляет отложенные расстояния и маршруты. Остановки к этому моменту
+	// уже в справочнике, поэтому поиск по именам делится между threads потоками.
+	void Finish(size_t threads = 1);
+
+private:
+	struct Request {
+		requests::Type type = requests::Type::UNKNOWN;
+		std::string name;
+		double latitude = 0;
+		double longitude = 0;
+		bool is_roundtrip = false;
+		std::vector<std::pair<std::string_view, int>> distances;
+		std::vector<std::string_view> stops;
+	};
+
+	struct PendingBus {
+		std::string_view name;
+		std::vector<std::string_view> stops;
+		bool is_roundtrip;
+	};
+
+	struct PendingStop {
+		std::string_view name;
+		geo::Coordinates coordinates;
+		// Конец расстояний остановки в stop_distances_
+		size_t distances_end;
+	};
+
+	void SetNumber(double value);
+	void EndRequest();
+
+	catalogue::TransportCatalogue& catalogue_;
+	Mode mode_;
+	// Имена из расстояний и маршрутов, которые понадобятся в Finish
+	catalogue::detail::NameArena pending_names_;
+	int depth_ = 0;
+	requests::Field field_ = requests::Field::UNKNOWN;
+	std::string_view distance_key_;
+	Request request_;
+	std::vector<std::tuple<catalogue::detail::Stop*, std::string_view, int>> distances_;
+	std::vector<PendingBus> buses_;
+	// Остановки режима DEFERRED
+	std::vector<PendingStop> stops_;
+	std::vector<std::pair<std::string_view, int>> stop_distances_;
+};
+
+// Формат документа команд и ответов
+enum class DataFormat {
+	JSON,
+	CBOR,
+};
 
 class JSONReader {
 public:
 	JSONReader(catalogue::TransportCatalogue& catalogue);
+	// Формат документа команд: для потокового режима это файл справочника,
+	// строки запросов в нём остаются в JSON
+	void SetInputFormat(DataFormat format);
+	// Формат ответов на stat_requests; потоковый режим всегда отвечает в JSON
+	void SetOutputFormat(DataFormat format);
+	// Каждая заново отрисованная карта дополнительно сохраняется в файл path
+	void SetMapFile(std::string path);
 	json::Document LoadJSON(const std::string& s);
 
 	void BaseRequest(catalogue::TransportCatalogue& catalogue, std::istream& input, std::ostream& output);
+	// То же, но документ читается из файла, отображённого в память
+	void BaseRequestFromFile(catalogue::TransportCatalogue& catalogue, const std::string& path, std::ostream& output);
+	// Потоковый режим: справочник и настройки загружаются из файла path,
+	// затем каждая строка input — отдельный запрос к базе, ответ на неё
+	// выводится одной строкой сразу после обработки. Ошибка разбора строки
+	// даёт ответ с error_message и не прерывает поток.
+	// Запрос Reload перечитывает path в отдельном потоке. Пока новая версия
+	// не опубликована, запросы обслуживает прежняя; ответ на Reload выводится,
+	// когда новая версия готова, и может прийти после ответов на следующие строки.
+	void ServeRequests(const std::string& path, std::istream& input, std::ostream& output);
 
 	std::string Print(const json::Node& node);
 
 	void ApplyCommands(json::Document& commands, catalogue::TransportCatalogue& catalogue);
 
-	json::Dict PrintGraph(const json::Node& req);
+	// Замораживает заполненный справочник. Настройки берутся из commands,
+	// маршрутизатор строится при первом запросе Route.
+	void ApplySettings(json::Document& commands, catalogue::TransportCatalogue& catalogue);
+
+	// Заполняет справочник из base_requests уже разобранного документа
+	void FillCatalogue(const json::Array& base_requests, catalogue::TransportCatalogue& catalogue);
+	void SetIngestThreads(size_t threads);
+
+	void PrintGraph(const requests::RouteRequest& request, const TransportRouter& router, json::Builder& builder);
 
 	void ParseAndPrintStat(json::Document& commands, const catalogue::TransportCatalogue& catalogue, std::ostream& output);
+	// Отвечает на уже разобранные запросы; настройки берутся из документа,
+	// переданного в ApplySettings
+	void ParseAndPrintStat(const std::vector<requests::StatRequest>& requests,
+		const catalogue::TransportCatalogue& catalogue, std::ostream& output);
 
 private:
-	std::unordered_map < std::string_view, int> ParseDistances(const json::Dict& stops);
+	struct StatOutput {
+		const catalogue::TransportCatalogue& catalogue;
+		json::ValueWriter& writer;
+		json::Builder& builder;
+		// Версия справочника в потоковом режиме: маршрутизатор берётся из неё
+		const catalogue::CatalogueVersion* version = nullptr;
+	};
+
+	void PrintStat(const requests::BusRequest& request, StatOutput& out);
+	void PrintStat(const requests::StopRequest& request, StatOutput& out);
+	void PrintStat(const requests::MapRequest& request, StatOutput& out);
+	void PrintStat(const requests::RouteRequest& request, StatOutput& out);
+	void PrintStat(const requests::NearbyRequest& request, StatOutput& out);
+	void PrintStat(const requests::InRadiusRequest& request, StatOutput& out);
+	void PrintStat(const requests::SuggestRequest& request, StatOutput& out);
+	void PrintStat(const requests::ReloadRequest& request, StatOutput& out);
+
+	// Разбирает base_requests и stat_requests; остальные разделы только
+	// размечаются и разбираются, когда понадобятся запросам
+	void ProcessCommands(std::string_view text, catalogue::TransportCatalogue& catalogue, std::ostream& output);
+	// Заполняет справочник из base_requests и размечает остальные разделы;
+	// stat_requests попадают в stat_requests, если он задан. Массивы запросов
+	// большого документа JSON разбираются по частям в ingest_threads_ потоках.
+	json::Sections LoadSections(std::string_view text, catalogue::TransportCatalogue& catalogue,
+		requests::StatRequestsHandler* stat_requests) const;
+	// Загружает справочник и настройки из файла в новый объект и публикует
+	// его как следующую версию. Не трогает состояние обработки запросов,
+	// поэтому может выполняться в отдельном потоке.
+	uint64_t PublishVersion(const std::string& path, catalogue::VersionedCatalogue& versions) const;
+	// Выполняется в потоке перезагрузки: публикует версию и выводит ответ
+	// на запрос Reload строкой в output
+	void Reload(const std::string& path, int request_id, catalogue::VersionedCatalogue& versions,
+		std::ostream& output, std::mutex& output_mutex);
+	// Источник настроек на время обработки документа. Разобранные разделы и
+	// маршрутизатор сбрасываются при смене источника и при выходе из области,
+	// в том числе по исключению, так что указатели на документ не переживают его.
+	class SettingsScope {
+	public:
+		SettingsScope(JSONReader& reader, const json::Sections& sections);
+		SettingsScope(JSONReader& reader, const json::Dict& commands);
+		SettingsScope(const SettingsScope&) = delete;
+		SettingsScope& operator=(const SettingsScope&) = delete;
+		~SettingsScope();
+
+	private:
+		JSONReader& reader_;
+	};
 
-	std::vector<std::string_view> ParseRoute(const json::Array& route, const bool& is_roundtrip);
+	// Забывает источник настроек и всё, что из него построено
+	void ResetSettings();
+	// Раздел настроек из документа команд, разобранный при первом обращении
+	const json::Node& GetSection(const std::string& key);
+	json::Node ParseSection(std::string_view text) const;
+	// Строит маршрутизатор по routing_settings, если он ещё не построен
+	void PrepareTransportRouter(const catalogue::TransportCatalogue& catalogue);
+	// SVG карты, уже закодированный для writer. Отрисовывается и кодируется
+	// при первом запросе и используется, пока не изменились данные
+	// справочника, настройки отрисовки или формат вывода.
+	const std::string& GetMap(const catalogue::TransportCatalogue& catalogue, const json::ValueWriter& writer);
+	// Источник настроек: дерево документа или размеченный текст
+	const json::Dict* commands_ = nullptr;
+	const json::Sections* sections_ = nullptr;
+	json::Dict parsed_sections_;
+	bool router_ready_ = false;
+	struct MapCache {
+		uint64_t catalogue_version;
+		json::Dict render_settings;
+		// Формат вывода определяется типом writer
+		std::type_index encoding;
+		std::string encoded_svg;
+	};
+	std::optional<MapCache> map_cache_;
+	std::string map_file_;
+	std::vector<catalogue::detail::Stop*> ParseRoute(const json::Array& route, catalogue::TransportCatalogue& catalogue);
 	TransportRouter transport_router_;
-	json::Array SetToArray(std::set<std::string_view> original);
+	size_t ingest_threads_;
+	DataFormat input_format_ = DataFormat::JSON;
+	DataFormat output_format_ = DataFormat::JSON;
+	void WriteBuses(json::Builder& builder, catalogue::TransportCatalogue::BusesRange buses);
+	void WriteStopDistances(json::Builder& builder, const std::vector<catalogue::detail::StopDistance>& stops);
+	void WriteSuggestions(json::Builder& builder, const std::vector<catalogue::detail::NameSuggestion>& names);
+	void WriteNotFound(json::Builder& builder, int request_id);
+	void WriteError(json::Builder& builder, std::string message, std::optional<int> request_id = std::nullopt);
 	catalogue::TransportCatalogue& catalogue_;
 };
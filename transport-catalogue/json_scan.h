@@ -0,0 +1,217 @@
+#pragma once
+
+// Поиск символов, важных для разбора и вывода JSON. У каждого поиска две
+// реализации: посимвольная (...Scalar) и блочная на SSE2/AVX2. Обе видны
+// снаружи, чтобы тест мог сравнить их на одних и тех же данных. С
+// -DJSON_SCALAR_SCAN или без SSE2 блочные функции сводятся к посимвольным.
+
+#if defined(__SSE2__) && !defined(JSON_SCALAR_SCAN)
+#define JSON_SIMD_SCAN
+#include <immintrin.h>
+#endif
+
+namespace json::scan {
+
+inline bool IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// Конец строки, начало escape-последовательности и недопустимый перевод строки
+inline bool IsStringSpecial(char c) {
+    return c == '"' || c == '\\' || c == '\n' || c == '\r';
+}
+
+// Символы, важные при пропуске значения: кавычка и скобки
+inline bool IsStructural(char c) {
+    return c == '"' || c == '[' || c == ']' || c == '{' || c == '}';
+}
+
+// Символы, которые Writer выводит escape-последовательностью
+inline bool NeedsEscape(char c) {
+    return c == '\n' || c == '\r' || c == '\t' || c == '"' || c == '\\';
+}
+
+inline const char* SkipSpacesScalar(const char* it, const char* end) {
+    while (it != end && IsSpace(*it)) {
+        ++it;
+    }
+    return it;
+}
+
+inline const char* FindStringSpecialScalar(const char* it, const char* end) {
+    while (it != end && !IsStringSpecial(*it)) {
+        ++it;
+    }
+    return it;
+}
+
+inline const char* FindStructuralScalar(const char* it, const char* end) {
+    while (it != end && !IsStructural(*it)) {
+        ++it;
+    }
+    return it;
+}
+
+inline const char* FindEscapedScalar(const char* it, const char* end) {
+    while (it != end && !NeedsEscape(*it)) {
+        ++it;
+    }
+    return it;
+}
+
+#ifdef JSON_SIMD_SCAN
+
+// Поиск ведётся блоками по 16 (SSE2) или 32 (AVX2) байта: сравнения дают
+// битовую маску, позиция первого подходящего байта — её младший бит.
+// Хвост короче блока проверяется посимвольно.
+
+inline unsigned SpaceMask(__m128i chunk) {
+    const __m128i space = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+    // \t, \n, \v, \f, \r идут подряд (9..13): после сдвига на 9 они не больше 4
+    const __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8(9));
+    const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(space, control)));
+}
+
+inline unsigned StringSpecialMask(__m128i chunk) {
+    const __m128i quote = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+    const __m128i backslash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+    const __m128i newline = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+    const __m128i carriage = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'));
+    return static_cast<unsigned>(_mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(quote, backslash), _mm_or_si128(newline, carriage))));
+}
+
+// '[' и ']' отличаются от '{' и '}' только битом 0x20
+inline unsigned StructuralMask(__m128i chunk) {
+    const __m128i quote = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+    const __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    const __m128i open = _mm_cmpeq_epi8(folded, _mm_set1_epi8('{'));
+    const __m128i close = _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(quote, _mm_or_si128(open, close))));
+}
+
+inline unsigned EscapedMask(__m128i chunk) {
+    const __m128i quotes = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+        _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+    const __m128i controls = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+        _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(quotes, controls)));
+}
+
+#ifdef __AVX2__
+inline unsigned SpaceMask(__m256i chunk) {
+    const __m256i space = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+    const __m256i shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8(9));
+    const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(space, control)));
+}
+
+inline unsigned StringSpecialMask(__m256i chunk) {
+    const __m256i quote = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+    const __m256i backslash = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+    const __m256i newline = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'));
+    const __m256i carriage = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'));
+    return static_cast<unsigned>(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_or_si256(quote, backslash), _mm256_or_si256(newline, carriage))));
+}
+
+inline unsigned StructuralMask(__m256i chunk) {
+    const __m256i quote = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+    const __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+    const __m256i open = _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{'));
+    const __m256i close = _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'));
+    return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(quote, _mm256_or_si256(open, close))));
+}
+#endif
+
+inline const char* SkipSpaces(const char* it, const char* end) {
+    // Чаще всего пробелов нет совсем
+    if (it == end || !IsSpace(*it)) {
+        return it;
+    }
+#ifdef __AVX2__
+    for (; end - it >= 32; it += 32) {
+        const unsigned mask = ~SpaceMask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it)));
+        if (mask != 0) {
+            return it + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; end - it >= 16; it += 16) {
+        const unsigned mask = ~SpaceMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it))) & 0xFFFFu;
+        if (mask != 0) {
+            return it + __builtin_ctz(mask);
+        }
+    }
+    return SkipSpacesScalar(it, end);
+}
+
+inline const char* FindStringSpecial(const char* it, const char* end) {
+#ifdef __AVX2__
+    for (; end - it >= 32; it += 32) {
+        const unsigned mask = StringSpecialMask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it)));
+        if (mask != 0) {
+            return it + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; end - it >= 16; it += 16) {
+        const unsigned mask = StringSpecialMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)));
+        if (mask != 0) {
+            return it + __builtin_ctz(mask);
+        }
+    }
+    return FindStringSpecialScalar(it, end);
+}
+
+inline const char* FindStructural(const char* it, const char* end) {
+#ifdef __AVX2__
+    for (; end - it >= 32; it += 32) {
+        const unsigned mask = StructuralMask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it)));
+        if (mask != 0) {
+            return it + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; end - it >= 16; it += 16) {
+        const unsigned mask = StructuralMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)));
+        if (mask != 0) {
+            return it + __builtin_ctz(mask);
+        }
+    }
+    return FindStructuralScalar(it, end);
+}
+
+// Строки в ответах обычно короткие, поэтому только SSE2
+inline const char* FindEscaped(const char* it, const char* end) {
+    for (; end - it >= 16; it += 16) {
+        const unsigned mask = EscapedMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)));
+        if (mask != 0) {
+            return it + __builtin_ctz(mask);
+        }
+    }
+    return FindEscapedScalar(it, end);
+}
+
+#else
+
+inline const char* SkipSpaces(const char* it, const char* end) {
+    return SkipSpacesScalar(it, end);
+}
+
+inline const char* FindStringSpecial(const char* it, const char* end) {
+    return FindStringSpecialScalar(it, end);
+}
+
+inline const char* FindStructural(const char* it, const char* end) {
+    return FindStructuralScalar(it, end);
+}
+
+inline const char* FindEscaped(const char* it, const char* end) {
+    return FindEscapedScalar(it, end);
+}
+
+#endif
+
+}  // namespace json::scan
@@ -0,0 +1,227 @@
+#include "json_writer.h"
+#include "json_scan.h"
+
+namespace json {
+
+using namespace std::literals;
+
+namespace {
+
+std::string_view EscapeSequence(char c) {
+    switch (c) {
+    case '\n':
+        return "\\n"sv;
+    case '\r':
+        return "\\r"sv;
+    case '\t':
+        return "\\t"sv;
+    case '"':
+        return "\\\""sv;
+    default:
+        return "\\\\"sv;
+    }
+}
+
+// Передаёт строку частями: участки без специальных символов целиком,
+// между ними — escape-последовательности
+template <typename Append>
+void ForEachEscaped(std::string_view text, Append append) {
+    const char* it = text.data();
+    const char* end = it + text.size();
+    while (true) {
+        const char* special = scan::FindEscaped(it, end);
+        append(std::string_view{ it, static_cast<size_t>(special - it) });
+        if (special == end) {
+            break;
+        }
+        append(EscapeSequence(*special));
+        it = special + 1;
+    }
+}
+
+}  // namespace
+
+void ValueWriter::Value(const Node& node) {
+    if (node.IsNull()) {
+        Null();
+    }
+    else if (node.IsBool()) {
+        Bool(node.AsBool());
+    }
+    else if (node.IsInt()) {
+        Int(node.AsInt());
+    }
+    else if (node.IsPureDouble()) {
+        Double(node.AsDouble());
+    }
+    else if (node.IsString()) {
+        String(node.AsString());
+    }
+    else if (node.IsArray()) {
+        StartArray();
+        for (const Node& item : node.AsArray()) {
+            Value(item);
+        }
+        EndArray();
+    }
+    else {
+        StartDict();
+        for (const auto& [key, value] : node.AsMap()) {
+            Key(key);
+            Value(value);
+        }
+        EndDict();
+    }
+}
+
+Writer::Writer(std::ostream& out, size_t buffer_size, Layout layout)
+    : out_(out)
+    , buffer_size_(buffer_size)
+    , layout_(layout)
+    , number_format_(format::GetNumberFormat(out)) {
+    buffer_.reserve(buffer_size_);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::Null() {
+    BeforeValue();
+    Append("null"sv);
+    AfterValue();
+}
+
+void Writer::Bool(bool value) {
+    BeforeValue();
+    Append(value ? "true"sv : "false"sv);
+    AfterValue();
+}
+
+void Writer::Int(int value) {
+    BeforeValue();
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    Append({ buffer, static_cast<size_t>(result.ptr - buffer) });
+    AfterValue();
+}
+
+void Writer::Double(double value) {
+    BeforeValue();
+    char buffer[format::MAX_NUMBER_SIZE];
+    const char* end = format::FormatDouble(buffer, buffer + format::MAX_NUMBER_SIZE, value, number_format_);
+    Append({ buffer, static_cast<size_t>(end - buffer) });
+    AfterValue();
+}
+
+void Writer::String(std::string_view value) {
+    BeforeValue();
+    Append("\""sv);
+    ForEachEscaped(value, [this](std::string_view part) {
+        Append(part);
+        });
+    Append("\""sv);
+    AfterValue();
+}
+
+std::string Writer::EncodeString(std::string_view value) const {
+    std::string encoded;
+    encoded.reserve(value.size() + 2);
+    encoded += '"';
+    ForEachEscaped(value, [&encoded](std::string_view part) {
+        encoded.append(part);
+        });
+    encoded += '"';
+    return encoded;
+}
+
+void Writer::Encoded(std::string_view value) {
+    BeforeValue();
+    Append(value);
+    AfterValue();
+}
+
+void Writer::StartArray() {
+    BeforeValue();
+    Append(layout_ == Layout::ONE_LINE ? "["sv : "[\n"sv);
+    has_items_.push_back(false);
+}
+
+void Writer::EndArray() {
+    has_items_.pop_back();
+    Append(layout_ == Layout::ONE_LINE ? "]"sv : "\n]"sv);
+    AfterValue();
+}
+
+void Writer::StartDict() {
+    BeforeValue();
+    Append(layout_ == Layout::ONE_LINE ? "{"sv : "{\n"sv);
+    has_items_.push_back(false);
+}
+
+void Writer::Key(std::string_view key) {
+    if (has_items_.back()) {
+        Append(layout_ == Layout::ONE_LINE ? ","sv : ",\n"sv);
+    }
+    has_items_.back() = true;
+    // Ключи, как и в json::Print, выводятся без экранирования
+    Append("\""sv);
+    Append(key);
+    Append(layout_ == Layout::ONE_LINE ? "\":"sv : "\": "sv);
+    after_key_ = true;
+}
+
+void Writer::EndDict() {
+    has_items_.pop_back();
+    Append(layout_ == Layout::ONE_LINE ? "}"sv : "\n}"sv);
+    AfterValue();
+}
+
+void Writer::Flush() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::Reset() {
+    buffer_.clear();
+    has_items_.clear();
+    after_key_ = false;
+}
+
+void Writer::BeforeValue() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (!has_items_.empty()) {
+        if (has_items_.back()) {
+            Append(layout_ == Layout::ONE_LINE ? ","sv : ",\n"sv);
+        }
+        has_items_.back() = true;
+    }
+}
+
+void Writer::AfterValue() {
+    if (layout_ == Layout::ONE_LINE && has_items_.empty()) {
+        Append("\n"sv);
+    }
+}
+
+void Writer::Append(std::string_view text) {
+    if (buffer_size_ != 0 && text.size() >= buffer_size_) {
+        // Длинный участок пишется в поток напрямую, минуя буфер
+        Flush();
+        out_.write(text.data(), static_cast<std::streamsize>(text.size()));
+        return;
+    }
+    buffer_.append(text);
+    FlushIfFull();
+}
+
+void Writer::FlushIfFull() {
+    if (buffer_size_ != 0 && buffer_.size() >= buffer_size_) {
+        Flush();
+    }
+}
+
+}  // namespace json
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.h"
+#include "number_format.h"
+
+namespace json {
+
+// Приёмник потокового вывода, не зависящий от формата: события разбора
+// плюс запись готовых узлов и сброс буфера
+class ValueWriter : public Handler {
+public:
+    // Записывает готовое значение целиком
+    void Value(const Node& node);
+    // Строка в том виде, в каком её выводит String(): для JSON — в кавычках
+    // и с экранированием. Результат можно сохранить и выводить повторно
+    // через Encoded(), не кодируя строку заново.
+    virtual std::string EncodeString(std::string_view value) const = 0;
+    // Записывает значение, уже закодированное EncodeString() этого формата
+    virtual void Encoded(std::string_view value) = 0;
+
+    virtual void Flush() = 0;
+};
+
+// Потоковая запись JSON в том же виде, что и json::Print. Текст копится в
+// буфере и уходит в поток крупными блоками, так что документ можно выводить
+// по частям, не собирая его целиком. Как обработчик событий разбора,
+// Writer переписывает разбираемый документ.
+class Writer final : public ValueWriter {
+public:
+    enum class Layout {
+        // Как json::Print: каждый элемент контейнера с новой строки
+        MULTILINE,
+        // Каждое значение верхнего уровня — одна строка (NDJSON)
+        ONE_LINE,
+    };
+
+    // При buffer_size == 0 текст уходит в поток только по Flush()
+    explicit Writer(std::ostream& out, size_t buffer_size = 1 << 20, Layout layout = Layout::MULTILINE);
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    ~Writer() override;
+
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+
+    std::string EncodeString(std::string_view value) const override;
+    void Encoded(std::string_view value) override;
+
+    void Flush() override;
+    // Отбрасывает недописанное значение: буфер и открытые контейнеры
+    void Reset();
+
+private:
+    void BeforeValue();
+    void AfterValue();
+    void Append(std::string_view text);
+    void FlushIfFull();
+
+    std::ostream& out_;
+    size_t buffer_size_;
+    Layout layout_;
+    std::string buffer_;
+    format::NumberFormat number_format_;
+    // Для каждого открытого контейнера: записан ли в него хотя бы один элемент
+    std::vector<bool> has_items_;
+    bool after_key_ = false;
+};
+
+}  // namespace json
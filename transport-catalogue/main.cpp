@@ -1,9 +1,59 @@
 #include "json_reader.h"
 #include <fstream>
+#include <string_view>
 using namespace std;
 
-int main() {
+namespace {
+
+DataFormat ParseFormat(string_view name) {
+    if (name == "json"sv) {
+        return DataFormat::JSON;
+    }
+    if (name == "cbor"sv) {
+        return DataFormat::CBOR;
+    }
+    throw invalid_argument("Unknown format "s + string(name));
+}
+
+}
+
+int main(int argc, char* argv[]) {
     catalogue::TransportCatalogue catalogue;
     JSONReader reader(catalogue);
-    reader.BaseRequest(catalogue, cin, cout);
-}
\ No newline at end of file
+    bool ndjson = false;
+    string path;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg == "--ndjson"sv) {
+            ndjson = true;
+        }
+        else if (arg.substr(0, 8) == "--input="sv) {
+            reader.SetInputFormat(ParseFormat(arg.substr(8)));
+        }
+        else if (arg.substr(0, 9) == "--output="sv) {
+            reader.SetOutputFormat(ParseFormat(arg.substr(9)));
+        }
+        else if (arg.substr(0, 11) == "--map-file="sv) {
+            // Отрисованная карта сохраняется ещё и в этот файл
+            reader.SetMapFile(string(arg.substr(11)));
+        }
+        else if (arg.substr(0, 10) == "--threads="sv) {
+            // Потоки для разбора и загрузки больших документов
+            reader.SetIngestThreads(stoul(string(arg.substr(10))));
+        }
+        else {
+            path = arg;
+        }
+    }
+    if (ndjson) {
+        // Справочник из файла, запросы — по одному в строке со стандартного ввода
+        reader.ServeRequests(path, cin, cout);
+    }
+    else if (!path.empty()) {
+        // Запросы читаются из файла, переданного аргументом
+        reader.BaseRequestFromFile(catalogue, path, cout);
+    }
+    else {
+        reader.BaseRequest(catalogue, cin, cout);
+    }
+}
@@ -46,8 +46,8 @@ RenderSettings MapRenderer::GetRenderSettings() {
 }
 
 
-void MapRenderer::FillText(const geo::Coordinates& point, svg::Text& text, const renderer::SphereProjector& proj, const std::string& bus_name) {
-	text.SetPosition(proj(point)).SetOffset(svg::Point(render_settings_.bus_label_offset[0], render_settings_.bus_label_offset[1])).SetFontSize(render_settings_.bus_label_font_size).SetFontFamily("Verdana").SetData(bus_name).SetFontWeight("bold").SetFillColor("black");
+void MapRenderer::FillText(const geo::Coordinates& point, svg::Text& text, const renderer::SphereProjector& proj, std::string_view bus_name) {
+	text.SetPosition(proj(point)).SetOffset(svg::Point(render_settings_.bus_label_offset[0], render_settings_.bus_label_offset[1])).SetFontSize(render_settings_.bus_label_font_size).SetFontFamily("Verdana").SetData(std::string(bus_name)).SetFontWeight("bold").SetFillColor("black");
 
 	}
 
@@ -57,7 +57,7 @@ void MapRenderer::FillStops(svg::Document& map, const renderer::SphereProjector&
 	map.Add(circle);
 
 	svg::Text stop_label;
-	stop_label.SetPosition(proj(geo::Coordinates{ stop->latitude,stop->longitude })).SetOffset(svg::Point(render_settings_.stop_label_offset[0], render_settings_.stop_label_offset[1])).SetFontSize(render_settings_.stop_label_font_size).SetFontFamily("Verdana").SetData(stop->name);
+	stop_label.SetPosition(proj(geo::Coordinates{ stop->latitude,stop->longitude })).SetOffset(svg::Point(render_settings_.stop_label_offset[0], render_settings_.stop_label_offset[1])).SetFontSize(render_settings_.stop_label_font_size).SetFontFamily("Verdana").SetData(std::string(stop->name));
 	svg::Text underlayer = stop_label;
 	underlayer.SetFillColor(render_settings_.underlayer_color).SetStrokeColor(render_settings_.underlayer_color).SetStrokeWidth(render_settings_.underlayer_width).SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 	stop_label.SetFillColor("black");
@@ -65,7 +65,7 @@ void MapRenderer::FillStops(svg::Document& map, const renderer::SphereProjector&
 	stops.push_back(stop_label);
 }
 
-void MapRenderer::FillMap(const catalogue::detail::Bus* bus, svg::Document& map, const renderer::SphereProjector& proj, int& number, bool is_roundtrip, std::vector<svg::Text>& buses) {
+void MapRenderer::FillMap(const catalogue::detail::Bus* bus, svg::Document& map, const renderer::SphereProjector& proj, int& number, std::vector<svg::Text>& buses) {
 	if (bus->stops.size() == 0) {
 		return;
 	}
@@ -76,7 +76,7 @@ void MapRenderer::FillMap(const catalogue::detail::Bus* bus, svg::Document& map,
 	polyline.SetFillColor(svg::Color());
 	polyline.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
 	polyline.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-	for (const auto& point : bus->stops) {
+	for (const auto* point : bus->GetRoute()) {
 		polyline.AddPoint(proj(geo::Coordinates{point->latitude,point->longitude}));
 	}
 	map.Add(polyline);
@@ -91,12 +91,13 @@ void MapRenderer::FillMap(const catalogue::detail::Bus* bus, svg::Document& map,
 	bus_label.SetFillColor(render_settings_.color_palette[number % render_settings_.color_palette.size()]);
 	buses.push_back(bus_label);
 
-	if (!is_roundtrip && (geo::Coordinates{ bus->stops[0]->latitude,bus->stops[0]->longitude } != geo::Coordinates{ bus->stops[bus->stops.size() / 2]->latitude,bus->stops[bus->stops.size() / 2]->longitude })) {
+	// Конечная некольцевого маршрута — последняя остановка прямого хода
+	if (!bus->is_roundtrip && (geo::Coordinates{ bus->stops[0]->latitude,bus->stops[0]->longitude } != geo::Coordinates{ bus->stops.back()->latitude,bus->stops.back()->longitude })) {
 		svg::Text underlayer_copy = underlayer;
-		underlayer_copy.SetPosition(proj(geo::Coordinates{ bus->stops[bus->stops.size() / 2]->latitude,bus->stops[bus->stops.size() / 2]->longitude }));
+		underlayer_copy.SetPosition(proj(geo::Coordinates{ bus->stops.back()->latitude,bus->stops.back()->longitude }));
 		buses.push_back(underlayer_copy);
 		svg::Text bus_label_copy = bus_label;
-		bus_label_copy.SetPosition(proj(geo::Coordinates{ bus->stops[bus->stops.size() / 2]->latitude,bus->stops[bus->stops.size() / 2]->longitude }));
+		bus_label_copy.SetPosition(proj(geo::Coordinates{ bus->stops.back()->latitude,bus->stops.back()->longitude }));
 		buses.push_back(bus_label_copy);
 	}
 	number += 1;
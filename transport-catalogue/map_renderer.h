@@ -101,8 +101,8 @@ public:
     svg::Color FillColor(const json::Node& colors);
     RenderSettings GetRenderSettings();
     void FillStops(svg::Document& map, const renderer::SphereProjector& proj,const catalogue::detail::Stop* stop, std::vector<svg::Text>& stops);
-    void FillMap(const catalogue::detail::Bus* bus, svg::Document& map, const renderer::SphereProjector& proj, int& number, bool is_roundtrip, std::vector<svg::Text>& buses);
-    void FillText(const geo::Coordinates& point, svg::Text& text, const renderer::SphereProjector& proj,const std::string& bus_name);
+    void FillMap(const catalogue::detail::Bus* bus, svg::Document& map, const renderer::SphereProjector& proj, int& number, std::vector<svg::Text>& buses);
+    void FillText(const geo::Coordinates& point, svg::Text& text, const renderer::SphereProjector& proj, std::string_view bus_name);
 
 private:
     RenderSettings render_settings_;
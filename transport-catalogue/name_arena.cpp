@@ -0,0 +1,59 @@
+#include "name_arena.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace catalogue {
+namespace detail {
+
+NameArena::NameArena(size_t block_size) :block_size_(block_size) {
+}
+
+std::string_view NameArena::Add(std::string_view name) {
+	if (name.empty()) {
+		// Пустой строке блок не нужен, а до первого блока писать некуда
+		return {};
+	}
+	if (block_used_ + name.size() > block_capacity_) {
+		block_capacity_ = std::max(block_size_, name.size());
+		blocks_.push_back(std::make_unique<char[]>(block_capacity_));
+		block_used_ = 0;
+	}
+	char* dest = blocks_.back().get() + block_used_;
+	std::memcpy(dest, name.data(), name.size());
+	block_used_ += name.size();
+	used_bytes_ += name.size();
+	return { dest, name.size() };
+}
+
+size_t NameArena::GetUsedBytes() const {
+	return used_bytes_;
+}
+
+void NameArena::Clear() {
+	if (blocks_.size() > 1) {
+		blocks_.resize(1);
+		block_capacity_ = block_size_;
+	}
+	block_used_ = 0;
+	used_bytes_ = 0;
+}
+
+void NameArena::Append(NameArena&& other) {
+	if (blocks_.empty()) {
+		std::swap(*this, other);
+		return;
+	}
+	// Текущий блок остаётся последним, чтобы дописывать в него дальше
+	blocks_.insert(blocks_.end() - 1, std::make_move_iterator(other.blocks_.begin()),
+		std::make_move_iterator(other.blocks_.end()));
+	used_bytes_ += other.used_bytes_;
+	other.blocks_.clear();
+	other.block_capacity_ = 0;
+	other.block_used_ = 0;
+	other.used_bytes_ = 0;
+}
+
+}
+}
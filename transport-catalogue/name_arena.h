@@ -0,0 +1,31 @@
+#pragma once
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace catalogue {
+namespace detail {
+
+// Хранилище имён остановок и автобусов: строки дописываются в большие блоки,
+// string_view на них остаются валидными всё время жизни хранилища.
+class NameArena {
+public:
+	explicit NameArena(size_t block_size = 64 * 1024);
+
+	std::string_view Add(std::string_view name);
+	size_t GetUsedBytes() const;
+	// Забывает все строки; первый блок остаётся для следующих
+	void Clear();
+	// Забирает блоки other: выданные им string_view остаются валидными
+	void Append(NameArena&& other);
+
+private:
+	size_t block_size_;
+	size_t block_capacity_ = 0;
+	size_t block_used_ = 0;
+	size_t used_bytes_ = 0;
+	std::vector<std::unique_ptr<char[]>> blocks_;
+};
+
+}
+}
@@ -0,0 +1,59 @@
+#include "number_format.h"
+
+#include <algorithm>
+
+namespace format {
+
+namespace {
+
+// Индексы ячеек потока, в которых хранится формат
+int FormatIndex() {
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+int PrecisionIndex() {
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+}  // namespace
+
+void SetNumberFormat(std::ostream& out, NumberFormat format) {
+    out.iword(FormatIndex()) = static_cast<long>(format.format);
+    // Ноль в ячейке означает точность по умолчанию
+    out.iword(PrecisionIndex()) = std::clamp(format.precision, 0, MAX_PRECISION) + 1;
+}
+
+NumberFormat GetNumberFormat(std::ostream& out) {
+    NumberFormat format;
+    format.format = static_cast<DoubleFormat>(out.iword(FormatIndex()));
+    if (const long precision = out.iword(PrecisionIndex()); precision != 0) {
+        format.precision = static_cast<int>(precision - 1);
+    }
+    return format;
+}
+
+char* FormatDouble(char* first, char* last, double value, const NumberFormat& format) {
+    std::to_chars_result result{};
+    switch (format.format) {
+    case DoubleFormat::SHORTEST:
+        result = std::to_chars(first, last, value);
+        break;
+    case DoubleFormat::FIXED:
+        result = std::to_chars(first, last, value, std::chars_format::fixed, format.precision);
+        break;
+    default:
+        result = std::to_chars(first, last, value, std::chars_format::general, format.precision);
+        break;
+    }
+    return result.ptr;
+}
+
+void WriteDouble(std::ostream& out, double value) {
+    char buffer[MAX_NUMBER_SIZE];
+    const char* end = FormatDouble(buffer, buffer + MAX_NUMBER_SIZE, value, GetNumberFormat(out));
+    out.write(buffer, end - buffer);
+}
+
+}  // namespace format
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <charconv>
+#include <iostream>
+#include <string_view>
+
+// Вывод чисел через std::to_chars без форматирования iostream и локалей.
+// Формат задаётся для потока, как std::setprecision, и по умолчанию совпадает
+// с выводом out << value.
+namespace format {
+
+enum class DoubleFormat {
+    // Как out << value: %g с заданной точностью
+    GENERAL,
+    // Кратчайшая запись, которая читается обратно в то же число
+    SHORTEST,
+    // Фиксированное число знаков после точки
+    FIXED,
+};
+
+struct NumberFormat {
+    DoubleFormat format = DoubleFormat::GENERAL;
+    int precision = 6;
+};
+
+// Точность ограничена, чтобы любое число помещалось в буфер
+constexpr int MAX_PRECISION = 64;
+constexpr size_t MAX_NUMBER_SIZE = 512;
+
+void SetNumberFormat(std::ostream& out, NumberFormat format);
+NumberFormat GetNumberFormat(std::ostream& out);
+
+// Записывает число в [first, last) и возвращает конец записи
+char* FormatDouble(char* first, char* last, double value, const NumberFormat& format);
+
+void WriteDouble(std::ostream& out, double value);
+
+template <typename Integer>
+void WriteInteger(std::ostream& out, Integer value) {
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.write(buffer, result.ptr - buffer);
+}
+
+}  // namespace format
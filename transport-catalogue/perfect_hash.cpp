@@ -0,0 +1,122 @@
+#include "perfect_hash.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace catalogue {
+namespace detail {
+
+namespace {
+// Максимальное число перебираемых смещений для одной корзины
+const uint32_t MAX_DISPLACEMENT = 1u << 20;
+const int MAX_SALT_ATTEMPTS = 16;
+}
+
+PerfectHash::PerfectHash(const std::vector<std::string_view>& keys) :size_(keys.size()) {
+	if (keys.empty()) {
+		return;
+	}
+	// Равные ключи не разделит никакая соль
+	std::vector<std::string_view> sorted = keys;
+	std::sort(sorted.begin(), sorted.end());
+	if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+		throw std::invalid_argument("Duplicate key in perfect hash");
+	}
+	std::vector<uint64_t> hashes(keys.size());
+	for (int attempt = 0; attempt < MAX_SALT_ATTEMPTS; ++attempt) {
+		salt_ = Mix(0x9E3779B97F4A7C15ull * (attempt + 1));
+		for (size_t i = 0; i < keys.size(); ++i) {
+			hashes[i] = Hash(keys[i], salt_);
+		}
+		if (TryBuild(hashes)) {
+			return;
+		}
+	}
+	throw std::logic_error("Failed to build perfect hash");
+}
+
+bool PerfectHash::TryBuild(const std::vector<uint64_t>& hashes) {
+	// В среднем по 4 ключа на корзину: раскладка остаётся быстрой,
+	// а таблица смещений занимает ~1 байт на ключ
+	const size_t bucket_count = size_ / 4 + 1;
+	std::vector<std::vector<uint64_t>> buckets(bucket_count);
+	for (uint64_t hash : hashes) {
+		buckets[hash % bucket_count].push_back(hash);
+	}
+	std::vector<size_t> order(bucket_count);
+	for (size_t i = 0; i < bucket_count; ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) {
+		return buckets[lhs].size() > buckets[rhs].size();
+	});
+
+	displacements_.assign(bucket_count, 0);
+	std::vector<bool> taken(size_, false);
+	std::vector<size_t> slots;
+	for (size_t bucket : order) {
+		const auto& items = buckets[bucket];
+		if (items.empty()) {
+			break;
+		}
+		uint32_t displacement = 0;
+		for (; displacement < MAX_DISPLACEMENT; ++displacement) {
+			slots.clear();
+			for (uint64_t hash : items) {
+				const size_t slot = Mix(hash + displacement) % size_;
+				if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+					break;
+				}
+				slots.push_back(slot);
+			}
+			if (slots.size() == items.size()) {
+				break;
+			}
+		}
+		if (displacement == MAX_DISPLACEMENT) {
+			return false;
+		}
+		for (size_t slot : slots) {
+			taken[slot] = true;
+		}
+		displacements_[bucket] = displacement;
+	}
+	return true;
+}
+
+size_t PerfectHash::Find(std::string_view key) const {
+	if (size_ == 0) {
+		return 0;
+	}
+	const uint64_t hash = Hash(key, salt_);
+	return Mix(hash + displacements_[hash % displacements_.size()]) % size_;
+}
+
+size_t PerfectHash::GetSize() const {
+	return size_;
+}
+
+size_t PerfectHash::GetMemoryBytes() const {
+	return displacements_.capacity() * sizeof(uint32_t);
+}
+
+uint64_t PerfectHash::Hash(std::string_view key, uint64_t salt) {
+	// FNV-1a с финальным перемешиванием
+	uint64_t hash = 0xcbf29ce484222325ull ^ salt;
+	for (char c : key) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 0x100000001b3ull;
+	}
+	return Mix(hash);
+}
+
+uint64_t PerfectHash::Mix(uint64_t value) {
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33;
+	return value;
+}
+
+}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace catalogue {
+namespace detail {
+
+// Минимальная совершенная хеш-функция (схема hash-and-displace) над
+// фиксированным набором строк. Find возвращает номер слота в [0, size);
+// для строк вне набора слот произвольный, поэтому вызывающий код обязан
+// сверить имя, хранящееся в этом слоте.
+class PerfectHash {
+public:
+	PerfectHash() = default;
+	// Ключи должны быть различны, иначе бросается std::invalid_argument
+	explicit PerfectHash(const std::vector<std::string_view>& keys);
+
+	size_t Find(std::string_view key) const;
+	size_t GetSize() const;
+	size_t GetMemoryBytes() const;
+
+private:
+	static uint64_t Hash(std::string_view key, uint64_t salt);
+	static uint64_t Mix(uint64_t value);
+	bool TryBuild(const std::vector<uint64_t>& hashes);
+
+	uint64_t salt_ = 0;
+	size_t size_ = 0;
+	std::vector<uint32_t> displacements_;
+};
+
+}
+}
@@ -0,0 +1,32 @@
+#include "prefix_index.h"
+#include <algorithm>
+
+namespace catalogue {
+namespace detail {
+
+PrefixIndex::PrefixIndex(const std::deque<Stop>& stops, const std::deque<Bus>& buses) {
+	names_.reserve(stops.size() + buses.size());
+	for (const Stop& stop : stops) {
+		names_.push_back({ stop.name, false });
+	}
+	for (const Bus& bus : buses) {
+		names_.push_back({ bus.name, true });
+	}
+	std::sort(names_.begin(), names_.end(), [](const NameSuggestion& lhs, const NameSuggestion& rhs) {
+		return lhs.name < rhs.name || (lhs.name == rhs.name && lhs.is_bus < rhs.is_bus);
+	});
+}
+
+std::vector<NameSuggestion> PrefixIndex::Suggest(std::string_view prefix, size_t count) const {
+	std::vector<NameSuggestion> result;
+	auto it = std::lower_bound(names_.begin(), names_.end(), prefix, [](const NameSuggestion& item, std::string_view value) {
+		return item.name < value;
+	});
+	for (; it != names_.end() && result.size() < count && it->name.substr(0, prefix.size()) == prefix; ++it) {
+		result.push_back(*it);
+	}
+	return result;
+}
+
+}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "domain.h"
+#include <deque>
+#include <string_view>
+#include <vector>
+
+namespace catalogue {
+namespace detail {
+
+struct NameSuggestion {
+	std::string_view name;
+	bool is_bus;
+};
+
+// Отсортированный массив имён остановок и автобусов для поиска по префиксу.
+// Запрос стоит O(log n + count) независимо от длины префикса.
+class PrefixIndex {
+public:
+	PrefixIndex() = default;
+	PrefixIndex(const std::deque<Stop>& stops, const std::deque<Bus>& buses);
+
+	// Первые count имён с заданным префиксом в лексикографическом порядке
+	std::vector<NameSuggestion> Suggest(std::string_view prefix, size_t count) const;
+
+private:
+	std::vector<NameSuggestion> names_;
+};
+
+}
+}
@@ -0,0 +1,258 @@
+#include "requests.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace requests {
+
+namespace {
+
+std::string_view FieldName(Field field) {
+    for (const auto& [name, value] : detail::FIELDS) {
+        if (value == field) {
+            return name;
+        }
+    }
+    return {};
+}
+
+}
+
+RequestFields::Value* RequestFields::Slot(Field field) {
+    Value& value = values_[static_cast<size_t>(field)];
+    if (field == Field::UNKNOWN || value.kind != Kind::NONE) {
+        return nullptr;
+    }
+    return &value;
+}
+
+void RequestFields::SetInt(Field field, int value) {
+    if (Value* slot = Slot(field)) {
+        slot->kind = Kind::INT;
+        slot->int_value = value;
+    }
+}
+
+void RequestFields::SetDouble(Field field, double value) {
+    if (Value* slot = Slot(field)) {
+        slot->kind = Kind::DOUBLE;
+        slot->double_value = value;
+    }
+}
+
+void RequestFields::SetString(Field field, std::string_view value) {
+    if (Value* slot = Slot(field)) {
+        slot->kind = Kind::STRING;
+        slot->string_value = value;
+    }
+}
+
+void RequestFields::SetOther(Field field) {
+    if (Value* slot = Slot(field)) {
+        slot->kind = Kind::OTHER;
+    }
+}
+
+void RequestFields::Clear() {
+    for (Value& value : values_) {
+        value.kind = Kind::NONE;
+    }
+}
+
+const RequestFields::Value& RequestFields::Get(Field field) const {
+    const Value& value = values_[static_cast<size_t>(field)];
+    if (value.kind == Kind::NONE) {
+        throw std::invalid_argument("No key " + std::string(FieldName(field)));
+    }
+    return value;
+}
+
+int RequestFields::GetInt(Field field) const {
+    const Value& value = Get(field);
+    if (value.kind != Kind::INT) {
+        throw std::logic_error("Not int");
+    }
+    return value.int_value;
+}
+
+double RequestFields::GetDouble(Field field) const {
+    const Value& value = Get(field);
+    if (value.kind == Kind::INT) {
+        return value.int_value;
+    }
+    if (value.kind != Kind::DOUBLE) {
+        throw std::logic_error("Not double");
+    }
+    return value.double_value;
+}
+
+std::string_view RequestFields::GetString(Field field) const {
+    const Value& value = Get(field);
+    if (value.kind != Kind::STRING) {
+        throw std::logic_error("Not string");
+    }
+    return value.string_value;
+}
+
+std::optional<StatRequest> RequestFields::Build() const {
+    const auto id = [this] {
+        return GetInt(Field::ID);
+    };
+    const auto point = [this] {
+        return geo::Coordinates{ GetDouble(Field::LATITUDE), GetDouble(Field::LONGITUDE) };
+    };
+    switch (FindType(GetString(Field::TYPE))) {
+    case Type::BUS:
+        return BusRequest{ id(), GetString(Field::NAME) };
+    case Type::STOP:
+        return StopRequest{ id(), GetString(Field::NAME) };
+    case Type::MAP:
+        return MapRequest{ id() };
+    case Type::ROUTE:
+        return RouteRequest{ id(), GetString(Field::FROM), GetString(Field::TO) };
+    case Type::NEARBY:
+        return NearbyRequest{ id(), point(), std::max(0, GetInt(Field::COUNT)) };
+    case Type::IN_RADIUS:
+        return InRadiusRequest{ id(), point(), GetDouble(Field::RADIUS) };
+    case Type::SUGGEST:
+        return SuggestRequest{ id(), GetString(Field::PREFIX), std::max(0, GetInt(Field::COUNT)) };
+    case Type::RELOAD:
+        return ReloadRequest{ id() };
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<StatRequest> DecodeStatRequest(const json::Node& request) {
+    RequestFields fields;
+    for (const auto& [key, value] : request.AsMap()) {
+        const Field field = FindField(key);
+        if (value.IsInt()) {
+            fields.SetInt(field, value.AsInt());
+        }
+        else if (value.IsPureDouble()) {
+            fields.SetDouble(field, value.AsDouble());
+        }
+        else if (value.IsString()) {
+            fields.SetString(field, value.AsString());
+        }
+        else {
+            fields.SetOther(field);
+        }
+    }
+    return fields.Build();
+}
+
+std::vector<StatRequest> DecodeStatRequests(const json::Array& requests) {
+    std::vector<StatRequest> result;
+    result.reserve(requests.size());
+    for (const auto& request : requests) {
+        if (auto decoded = DecodeStatRequest(request)) {
+            result.push_back(std::move(*decoded));
+        }
+    }
+    return result;
+}
+
+//-----------------------------StatRequestsHandler----------------------------------
+
+StatRequestsHandler::StatRequestsHandler(Root root)
+    :root_(root), depth_(root == Root::REQUEST ? 1 : 0) {
+}
+
+bool StatRequestsHandler::IsField() {
+    if (depth_ == 0) {
+        throw std::logic_error("Not array");
+    }
+    if (depth_ == 1) {
+        throw std::logic_error("Not map");
+    }
+    return depth_ == 2;
+}
+
+void StatRequestsHandler::Null() {
+    if (IsField()) {
+        fields_.SetOther(field_);
+    }
+}
+
+void StatRequestsHandler::Bool(bool /*value*/) {
+    if (IsField()) {
+        fields_.SetOther(field_);
+    }
+}
+
+void StatRequestsHandler::Int(int value) {
+    if (IsField()) {
+        fields_.SetInt(field_, value);
+    }
+}
+
+void StatRequestsHandler::Double(double value) {
+    if (IsField()) {
+        fields_.SetDouble(field_, value);
+    }
+}
+
+void StatRequestsHandler::String(std::string_view value) {
+    if (IsField() && field_ != Field::UNKNOWN) {
+        fields_.SetString(field_, names_.Add(value));
+    }
+}
+
+void StatRequestsHandler::StartArray() {
+    if (depth_ > 0 && IsField()) {
+        // Содержимое вложенных значений схеме не нужно: важен только тип
+        fields_.SetOther(field_);
+    }
+    ++depth_;
+}
+
+void StatRequestsHandler::EndArray() {
+    --depth_;
+}
+
+void StatRequestsHandler::StartDict() {
+    // Словарь на первом уровне — это сам запрос
+    if (depth_ != 1 && IsField()) {
+        fields_.SetOther(field_);
+    }
+    ++depth_;
+}
+
+void StatRequestsHandler::Key(std::string_view key) {
+    if (depth_ == 2) {
+        field_ = FindField(key);
+    }
+}
+
+void StatRequestsHandler::EndDict() {
+    --depth_;
+    if (depth_ == 1) {
+        if (auto request = fields_.Build()) {
+            requests_.push_back(std::move(*request));
+        }
+        fields_.Clear();
+        field_ = Field::UNKNOWN;
+    }
+}
+
+std::vector<StatRequest> StatRequestsHandler::Extract() {
+    return std::move(requests_);
+}
+
+void StatRequestsHandler::Clear() {
+    // Отдельный запрос разбирается так, будто он уже внутри массива
+    depth_ = root_ == Root::REQUEST ? 1 : 0;
+    field_ = Field::UNKNOWN;
+    fields_.Clear();
+    names_.Clear();
+    requests_.clear();
+}
+
+void StatRequestsHandler::Append(StatRequestsHandler&& other) {
+    requests_.insert(requests_.end(), other.requests_.begin(), other.requests_.end());
+    names_.Append(std::move(other.names_));
+    other.requests_.clear();
+}
+
+}  // namespace requests
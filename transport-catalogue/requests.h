@@ -0,0 +1,272 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include "geo.h"
+#include "json.h"
+#include "name_arena.h"
+
+// Схема входных запросов: ключи и типы запросов распознаются по таблицам,
+// построенным на этапе компиляции, а каждый запрос к базе разбирается
+// в собственную структуру.
+namespace requests {
+
+enum class Type {
+	UNKNOWN,
+	BUS,
+	STOP,
+	MAP,
+	ROUTE,
+	NEARBY,
+	IN_RADIUS,
+	SUGGEST,
+	RELOAD,
+};
+
+enum class Field {
+	UNKNOWN,
+	TYPE,
+	ID,
+	NAME,
+	FROM,
+	TO,
+	LATITUDE,
+	LONGITUDE,
+	RADIUS,
+	COUNT,
+	PREFIX,
+	STOPS,
+	IS_ROUNDTRIP,
+	ROAD_DISTANCES,
+};
+
+namespace detail {
+
+constexpr uint32_t Hash(std::string_view key) {
+	uint32_t hash = 2166136261u;
+	for (char c : key) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+	}
+	return hash;
+}
+
+template <typename Value>
+struct Entry {
+	std::string_view name;
+	Value value;
+};
+
+// Таблица с прямой адресацией по хешу. Размер подобран так, что ключи схемы
+// попадают в разные ячейки, и поиск сводится к одному сравнению строк.
+template <typename Value, size_t SIZE>
+struct KeyTable {
+	std::array<Entry<Value>, SIZE> slots{};
+	bool has_collisions = false;
+
+	constexpr Value Find(std::string_view key) const {
+		const Entry<Value>& slot = slots[Hash(key) % SIZE];
+		return slot.name == key ? slot.value : Value{};
+	}
+};
+
+template <typename Value, size_t SIZE, size_t N>
+constexpr KeyTable<Value, SIZE> MakeKeyTable(const Entry<Value>(&entries)[N]) {
+	KeyTable<Value, SIZE> table{};
+	for (const Entry<Value>& entry : entries) {
+		Entry<Value>& slot = table.slots[Hash(entry.name) % SIZE];
+		if (!slot.name.empty()) {
+			table.has_collisions = true;
+		}
+		slot = entry;
+	}
+	return table;
+}
+
+inline constexpr Entry<Type> TYPES[] = {
+	{ "Bus", Type::BUS },
+	{ "Stop", Type::STOP },
+	{ "Map", Type::MAP },
+	{ "Route", Type::ROUTE },
+	{ "Nearby", Type::NEARBY },
+	{ "InRadius", Type::IN_RADIUS },
+	{ "Suggest", Type::SUGGEST },
+	{ "Reload", Type::RELOAD },
+};
+
+inline constexpr Entry<Field> FIELDS[] = {
+	{ "type", Field::TYPE },
+	{ "id", Field::ID },
+	{ "name", Field::NAME },
+	{ "from", Field::FROM },
+	{ "to", Field::TO },
+	{ "latitude", Field::LATITUDE },
+	{ "longitude", Field::LONGITUDE },
+	{ "radius", Field::RADIUS },
+	{ "count", Field::COUNT },
+	{ "prefix", Field::PREFIX },
+	{ "stops", Field::STOPS },
+	{ "is_roundtrip", Field::IS_ROUNDTRIP },
+	{ "road_distances", Field::ROAD_DISTANCES },
+};
+
+inline constexpr auto TYPE_TABLE = MakeKeyTable<Type, 31>(TYPES);
+inline constexpr auto FIELD_TABLE = MakeKeyTable<Field, 31>(FIELDS);
+
+static_assert(!TYPE_TABLE.has_collisions, "Request types collide in TYPE_TABLE");
+static_assert(!FIELD_TABLE.has_collisions, "Request fields collide in FIELD_TABLE");
+
+}  // namespace detail
+
+inline Type FindType(std::string_view name) {
+	return detail::TYPE_TABLE.Find(name);
+}
+
+inline Field FindField(std::string_view key) {
+	return detail::FIELD_TABLE.Find(key);
+}
+
+struct BusRequest {
+	int id = 0;
+	std::string_view name;
+};
+
+struct StopRequest {
+	int id = 0;
+	std::string_view name;
+};
+
+struct MapRequest {
+	int id = 0;
+};
+
+struct RouteRequest {
+	int id = 0;
+	std::string_view from;
+	std::string_view to;
+};
+
+struct NearbyRequest {
+	int id = 0;
+	geo::Coordinates point;
+	int count = 0;
+};
+
+struct InRadiusRequest {
+	int id = 0;
+	geo::Coordinates point;
+	double radius = 0;
+};
+
+struct SuggestRequest {
+	int id = 0;
+	std::string_view prefix;
+	int count = 0;
+};
+
+// Перечитать справочник из файла; поддерживается только потоковым режимом
+struct ReloadRequest {
+	int id = 0;
+};
+
+// Строки запросов ссылаются на разобранный документ или на хранилище
+// StatRequestsHandler и живут, пока жив их источник
+using StatRequest = std::variant<BusRequest, StopRequest, MapRequest, RouteRequest,
+	NearbyRequest, InRadiusRequest, SuggestRequest, ReloadRequest>;
+
+// Значения полей одного запроса. Типы значений проверяются только при сборке
+// запроса и только для полей, нужных запросу этого типа.
+class RequestFields {
+public:
+	// Как и в словаре json::Dict, из повторяющихся ключей учитывается первый.
+	// Строка не копируется и должна жить до Build.
+	void SetInt(Field field, int value);
+	void SetDouble(Field field, double value);
+	void SetString(Field field, std::string_view value);
+	// Значение, которое схеме не подходит ни для одного поля: null, bool, массив, словарь
+	void SetOther(Field field);
+	void Clear();
+
+	// Запрос неизвестного типа пропускается
+	std::optional<StatRequest> Build() const;
+
+private:
+	enum class Kind {
+		NONE,
+		INT,
+		DOUBLE,
+		STRING,
+		OTHER,
+	};
+
+	struct Value {
+		Kind kind = Kind::NONE;
+		int int_value = 0;
+		double double_value = 0;
+		std::string_view string_value;
+	};
+
+	static constexpr size_t FIELD_COUNT = static_cast<size_t>(Field::ROAD_DISTANCES) + 1;
+
+	// Ячейка для записи или nullptr, если поле не нужно либо уже задано
+	Value* Slot(Field field);
+	const Value& Get(Field field) const;
+	int GetInt(Field field) const;
+	double GetDouble(Field field) const;
+	std::string_view GetString(Field field) const;
+
+	std::array<Value, FIELD_COUNT> values_;
+};
+
+// Разбирает запрос из дерева документа; строки запроса ссылаются на request
+std::optional<StatRequest> DecodeStatRequest(const json::Node& request);
+std::vector<StatRequest> DecodeStatRequests(const json::Array& requests);
+
+// Собирает запросы по событиям разбора массива stat_requests
+class StatRequestsHandler final : public json::Handler {
+public:
+	enum class Root {
+		// Массив запросов, как в разделе stat_requests
+		ARRAY,
+		// Один запрос, как в строке NDJSON
+		REQUEST,
+	};
+
+	explicit StatRequestsHandler(Root root = Root::ARRAY);
+
+	void Null() override;
+	void Bool(bool value) override;
+	void Int(int value) override;
+	void Double(double value) override;
+	void String(std::string_view value) override;
+	void StartArray() override;
+	void EndArray() override;
+	void StartDict() override;
+	void Key(std::string_view key) override;
+	void EndDict() override;
+
+	std::vector<StatRequest> Extract();
+	// Готовит обработчик к следующему документу. Строки выданных ранее
+	// запросов становятся недействительными, память переиспользуется.
+	void Clear();
+	// Дописывает запросы other, разобранные из следующей части массива,
+	// вместе с хранилищем их строк
+	void Append(StatRequestsHandler&& other);
+
+private:
+	// Проверяет, что значение стоит на месте поля запроса
+	bool IsField();
+
+	Root root_;
+	int depth_ = 0;
+	Field field_ = Field::UNKNOWN;
+	RequestFields fields_;
+	// Строки запросов: значения из буфера разбора живут только до следующего события
+	catalogue::detail::NameArena names_;
+	std::vector<StatRequest> requests_;
+};
+
+}  // namespace requests
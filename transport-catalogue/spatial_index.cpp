@@ -0,0 +1,155 @@
+#include "spatial_index.h"
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace catalogue {
+namespace detail {
+
+namespace {
+const double EARTH_RADIUS = 6371000;
+const double DEGREES_TO_RADIANS = 3.1415926535 / 180.;
+// Запас на погрешность вычислений при отсечении по хорде
+const double CHORD_EPSILON = 1e-9;
+}
+
+SpatialIndex::SpatialIndex(const std::deque<Stop>& stops) {
+	nodes_.reserve(stops.size());
+	for (const Stop& stop : stops) {
+		nodes_.push_back({ ToPoint({ stop.latitude, stop.longitude }), &stop, 0 });
+	}
+	Build(0, nodes_.size());
+}
+
+SpatialIndex::Point SpatialIndex::ToPoint(geo::Coordinates coordinates) {
+	const double lat = coordinates.lat * DEGREES_TO_RADIANS;
+	const double lng = coordinates.lng * DEGREES_TO_RADIANS;
+	return { std::cos(lat) * std::cos(lng), std::cos(lat) * std::sin(lng), std::sin(lat) };
+}
+
+double SpatialIndex::SquaredChord(const Point& lhs, const Point& rhs) {
+	double result = 0;
+	for (int i = 0; i < 3; ++i) {
+		result += (lhs[i] - rhs[i]) * (lhs[i] - rhs[i]);
+	}
+	return result;
+}
+
+void SpatialIndex::Build(size_t first, size_t last) {
+	if (last - first <= 1) {
+		return;
+	}
+	// Делим по оси с наибольшим разбросом: город занимает малый участок сферы,
+	// и циклический перебор осей давал бы вырожденные разбиения
+	Point min = nodes_[first].point;
+	Point max = min;
+	for (size_t i = first + 1; i < last; ++i) {
+		for (int axis = 0; axis < 3; ++axis) {
+			min[axis] = std::min(min[axis], nodes_[i].point[axis]);
+			max[axis] = std::max(max[axis], nodes_[i].point[axis]);
+		}
+	}
+	int axis = 0;
+	for (int i = 1; i < 3; ++i) {
+		if (max[i] - min[i] > max[axis] - min[axis]) {
+			axis = i;
+		}
+	}
+	const size_t middle = first + (last - first) / 2;
+	std::nth_element(nodes_.begin() + first, nodes_.begin() + middle, nodes_.begin() + last,
+		[axis](const Node& lhs, const Node& rhs) { return lhs.point[axis] < rhs.point[axis]; });
+	nodes_[middle].axis = axis;
+	Build(first, middle);
+	Build(middle + 1, last);
+}
+
+template <typename Visitor>
+void SpatialIndex::Search(size_t first, size_t last, const Point& point, double& bound, Visitor& visit) const {
+	if (first >= last) {
+		return;
+	}
+	const size_t middle = first + (last - first) / 2;
+	const Node& node = nodes_[middle];
+	const double squared_chord = SquaredChord(point, node.point);
+	if (squared_chord <= bound) {
+		visit(node.stop, squared_chord);
+	}
+	const double diff = point[node.axis] - node.point[node.axis];
+	if (diff < 0) {
+		Search(first, middle, point, bound, visit);
+		if (diff * diff <= bound) {
+			Search(middle + 1, last, point, bound, visit);
+		}
+	}
+	else {
+		Search(middle + 1, last, point, bound, visit);
+		if (diff * diff <= bound) {
+			Search(first, middle, point, bound, visit);
+		}
+	}
+}
+
+std::vector<StopDistance> SpatialIndex::FindNearest(geo::Coordinates point, size_t count) const {
+	if (count == 0) {
+		return {};
+	}
+	using Candidate = std::pair<double, const Stop*>;
+	auto farther_name = [](const Candidate& lhs, const Candidate& rhs) {
+		return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second->name < rhs.second->name);
+	};
+	std::priority_queue<Candidate, std::vector<Candidate>, decltype(farther_name)> nearest(farther_name);
+	double bound = std::numeric_limits<double>::infinity();
+	auto visit = [&](const Stop* stop, double squared_chord) {
+		nearest.push({ squared_chord, stop });
+		if (nearest.size() > count) {
+			nearest.pop();
+		}
+		if (nearest.size() == count) {
+			bound = nearest.top().first;
+		}
+	};
+	Search(0, nodes_.size(), ToPoint(point), bound, visit);
+
+	std::vector<const Stop*> stops;
+	stops.reserve(nearest.size());
+	for (; !nearest.empty(); nearest.pop()) {
+		stops.push_back(nearest.top().second);
+	}
+	return WithDistances(point, stops);
+}
+
+std::vector<StopDistance> SpatialIndex::FindInRadius(geo::Coordinates point, double radius) const {
+	if (radius < 0) {
+		return {};
+	}
+	const double angle = radius / EARTH_RADIUS;
+	const double chord = angle < 3.1415926535 ? 2 * std::sin(angle / 2) : 2.;
+	double bound = chord * chord + CHORD_EPSILON;
+	std::vector<const Stop*> stops;
+	auto visit = [&stops](const Stop* stop, double) {
+		stops.push_back(stop);
+	};
+	Search(0, nodes_.size(), ToPoint(point), bound, visit);
+
+	std::vector<StopDistance> result = WithDistances(point, stops);
+	result.erase(std::find_if(result.begin(), result.end(), [radius](const StopDistance& item) {
+		return item.distance > radius;
+	}), result.end());
+	return result;
+}
+
+std::vector<StopDistance> SpatialIndex::WithDistances(geo::Coordinates point, const std::vector<const Stop*>& stops) const {
+	const geo::PreparedCoordinates from = geo::Prepare(point);
+	std::vector<StopDistance> result;
+	result.reserve(stops.size());
+	for (const Stop* stop : stops) {
+		result.push_back({ stop, geo::ComputeDistance(from, stop->GetPreparedCoordinates()) });
+	}
+	std::sort(result.begin(), result.end(), [](const StopDistance& lhs, const StopDistance& rhs) {
+		return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.stop->name < rhs.stop->name);
+	});
+	return result;
+}
+
+}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "domain.h"
+#include <array>
+#include <deque>
+#include <vector>
+
+namespace catalogue {
+namespace detail {
+
+struct StopDistance {
+	const Stop* stop;
+	double distance;
+};
+
+// k-d дерево по остановкам. Координаты переводятся в точки единичной сферы,
+// поэтому евклидово (хордовое) расстояние монотонно зависит от расстояния по
+// поверхности Земли и поиск даёт точный результат без поправок на проекцию.
+class SpatialIndex {
+public:
+	SpatialIndex() = default;
+	explicit SpatialIndex(const std::deque<Stop>& stops);
+
+	// Ближайшие count остановок, упорядоченные по возрастанию расстояния
+	std::vector<StopDistance> FindNearest(geo::Coordinates point, size_t count) const;
+	// Остановки не дальше radius метров, упорядоченные по возрастанию расстояния
+	std::vector<StopDistance> FindInRadius(geo::Coordinates point, double radius) const;
+
+private:
+	using Point = std::array<double, 3>;
+	struct Node {
+		Point point;
+		const Stop* stop;
+		int axis;
+	};
+
+	static Point ToPoint(geo::Coordinates coordinates);
+	static double SquaredChord(const Point& lhs, const Point& rhs);
+	void Build(size_t first, size_t last);
+	template <typename Visitor>
+	void Search(size_t first, size_t last, const Point& point, double& bound, Visitor& visit) const;
+	std::vector<StopDistance> WithDistances(geo::Coordinates point, const std::vector<const Stop*>& stops) const;
+
+	std::vector<Node> nodes_;
+};
+
+}
+}
@@ -62,8 +62,13 @@ Circle& Circle::SetRadius(double radius)  {
 
 void Circle::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
-    out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-    out << "r=\""sv << radius_ << "\" "sv;
+    out << "<circle cx=\""sv;
+    format::WriteDouble(out, center_.x);
+    out << "\" cy=\""sv;
+    format::WriteDouble(out, center_.y);
+    out << "\" r=\""sv;
+    format::WriteDouble(out, radius_);
+    out << "\" "sv;
     RenderAttrs(context.out);
     out << "/>"sv;
 }
@@ -83,7 +88,9 @@ void Polyline::RenderObject(const RenderContext& context) const {
         if (!is_first) {
             out << " ";
         }
-        out << point.x << "," << point.y;
+        format::WriteDouble(out, point.x);
+        out << ",";
+        format::WriteDouble(out, point.y);
         is_first = false;
     }
     out << "\" "sv;
@@ -150,7 +157,17 @@ void Text::RenderObject(const RenderContext& context) const{
     auto& out = context.out;
     out << "<text"sv;
     RenderAttrs(context.out);
-    out<<" x=\""sv << position_.x << "\" y=\"" << position_.y << "\" dx=\"" << offset_.x << "\" dy=\"" << offset_.y << "\" font-size=\"" << font_size_ << "\"";
+    out << " x=\""sv;
+    format::WriteDouble(out, position_.x);
+    out << "\" y=\""sv;
+    format::WriteDouble(out, position_.y);
+    out << "\" dx=\""sv;
+    format::WriteDouble(out, offset_.x);
+    out << "\" dy=\""sv;
+    format::WriteDouble(out, offset_.y);
+    out << "\" font-size=\""sv;
+    format::WriteInteger(out, font_size_);
+    out << "\"";
     if (!font_family_.empty()) {
         out<< " font-family=\"" << font_family_ << "\"";
     }
@@ -7,6 +7,9 @@
 #include <vector>
 #include <optional>
 #include <variant>
+
+#include "number_format.h"
+
 namespace svg {
 
 enum class StrokeLineCap {
@@ -125,11 +128,26 @@ struct OstreamColor {
     }
 
     void operator()(Rgb color) {
-        out << "rgb(" << std::to_string(color.red) << "," << std::to_string(color.green) << "," << std::to_string(color.blue) << ")";
+        out << "rgb(";
+        WriteComponents(color.red, color.green, color.blue);
+        out << ")";
     }
 
     void operator()(Rgba color) {
-        out << "rgba(" << std::to_string(color.red) << "," << std::to_string(color.green) << "," << std::to_string(color.blue)<<","<<color.opacity << ")";
+        out << "rgba(";
+        WriteComponents(color.red, color.green, color.blue);
+        out << ",";
+        format::WriteDouble(out, color.opacity);
+        out << ")";
+    }
+
+private:
+    void WriteComponents(uint8_t red, uint8_t green, uint8_t blue) const {
+        format::WriteInteger(out, red);
+        out << ",";
+        format::WriteInteger(out, green);
+        out << ",";
+        format::WriteInteger(out, blue);
     }
 };
 
@@ -185,7 +203,9 @@ protected:
             out << "\""sv;
         }
         if (stroke_width_) {
-            out << " stroke-width=\""sv << *stroke_width_ << "\""sv;
+            out << " stroke-width=\""sv;
+            format::WriteDouble(out, *stroke_width_);
+            out << "\""sv;
         }
         if (stroke_line_cap_) {
             out << " stroke-linecap=\""sv << *stroke_line_cap_ << "\""sv;
@@ -0,0 +1,220 @@
+// Сравнивает блочные поиски из json_scan.h с посимвольными и проверяет,
+// что строки с escape-последовательностями на границах блоков выводятся и
+// читаются без искажений. Сборка и запуск из каталога transport-catalogue:
+//
+//   g++ -std=c++17 -O2 -I. tests/json_scan_test.cpp json.cpp json_writer.cpp number_format.cpp -o json_scan_test
+//   ./json_scan_test
+//
+// С -mavx2 проверяются и 32-байтные блоки. С -DJSON_SCALAR_SCAN обе
+// реализации совпадают, и тест проверяет только вывод и разбор строк.
+
+#include "json.h"
+#include "json_scan.h"
+#include "json_writer.h"
+
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std::literals;
+
+namespace {
+
+using Scan = const char* (*)(const char*, const char*);
+
+struct ScanCase {
+    std::string_view name;
+    Scan fast;
+    Scan scalar;
+    // Символы, на которых поиск должен остановиться
+    std::string_view targets;
+    // Символы, которые поиск должен пропускать, в том числе похожие на целевые
+    std::string_view background;
+};
+
+const ScanCase SCANS[] = {
+    { "SkipSpaces"sv, json::scan::SkipSpaces, json::scan::SkipSpacesScalar,
+        "a\0\x08\x0e\x1f!\x80\xff"sv, " \t\n\v\f\r"sv },
+    { "FindStringSpecial"sv, json::scan::FindStringSpecial, json::scan::FindStringSpecialScalar,
+        "\"\\\n\r"sv, "a\t\v\f\x0c\x0e!#[]{}\xa2\xdc\x8a"sv },
+    { "FindStructural"sv, json::scan::FindStructural, json::scan::FindStructuralScalar,
+        "\"[]{}"sv, "a;=Z\\^z|~\x1b\x1d\xdb\xdd\xfb\xfd\xa2"sv },
+    { "FindEscaped"sv, json::scan::FindEscaped, json::scan::FindEscapedScalar,
+        "\n\r\t\"\\"sv, "a\v\f\x0b\x0c\x0e !#[]{}\x8a\x89\xdc"sv },
+};
+
+// Длины до трёх 32-байтных блоков: все границы блоков и хвосты
+constexpr size_t MAX_LENGTH = 100;
+// Сдвиги начала, чтобы блоки читались по невыровненным адресам
+constexpr size_t MAX_OFFSET = 4;
+constexpr int RANDOM_BUFFERS = 20000;
+constexpr int MAX_REPORTED = 20;
+
+int failures = 0;
+
+void Fail(const std::string& message) {
+    if (++failures <= MAX_REPORTED) {
+        std::cerr << "FAIL: " << message << '\n';
+    }
+}
+
+void Compare(const ScanCase& scan, const std::string& buffer, size_t begin, size_t end) {
+    const char* first = buffer.data() + begin;
+    const char* last = buffer.data() + end;
+    const char* fast = scan.fast(first, last);
+    const char* scalar = scan.scalar(first, last);
+    if (fast != scalar) {
+        std::ostringstream message;
+        message << scan.name << " on [" << begin << ", " << end << ") of " << buffer.size()
+            << " bytes: " << (fast - first) << " instead of " << (scalar - first);
+        Fail(message.str());
+    }
+}
+
+// Один целевой символ в каждой позиции буфера из фоновых символов
+void TestSingleTarget() {
+    for (const ScanCase& scan : SCANS) {
+        for (size_t offset = 0; offset < MAX_OFFSET; ++offset) {
+            for (size_t length = 0; length <= MAX_LENGTH; ++length) {
+                std::string buffer(offset + length, 'x');
+                for (size_t i = 0; i < length; ++i) {
+                    buffer[offset + i] = scan.background[i % scan.background.size()];
+                }
+                // Без целевого символа поиск доходит до конца
+                Compare(scan, buffer, offset, buffer.size());
+                for (size_t pos = 0; pos < length; ++pos) {
+                    const char saved = buffer[offset + pos];
+                    for (const char target : scan.targets) {
+                        buffer[offset + pos] = target;
+                        Compare(scan, buffer, offset, buffer.size());
+                    }
+                    buffer[offset + pos] = saved;
+                }
+            }
+        }
+    }
+}
+
+// Случайные буферы: произвольные байты, символы из наборов поисков и
+// длинные пробельные участки
+void TestRandomBuffers() {
+    std::string interesting;
+    for (const ScanCase& scan : SCANS) {
+        interesting.append(scan.targets);
+        interesting.append(scan.background);
+    }
+    const std::string_view spaces = SCANS[0].background;
+
+    std::mt19937 random(20261019);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int n = 0; n < RANDOM_BUFFERS; ++n) {
+        const size_t size = std::uniform_int_distribution<size_t>(0, 3 * MAX_LENGTH)(random);
+        const int kind = n % 3;
+        std::string buffer(size, '\0');
+        for (char& c : buffer) {
+            if (kind == 0) {
+                c = static_cast<char>(byte(random));
+            }
+            else if (kind == 1) {
+                c = interesting[byte(random) % interesting.size()];
+            }
+            else {
+                // Пробелы с редкими вкраплениями других символов
+                c = byte(random) < 8 ? interesting[byte(random) % interesting.size()]
+                    : spaces[byte(random) % spaces.size()];
+            }
+        }
+        const size_t begin = std::uniform_int_distribution<size_t>(0, size)(random);
+        const size_t end = std::uniform_int_distribution<size_t>(begin, size)(random);
+        for (const ScanCase& scan : SCANS) {
+            Compare(scan, buffer, begin, end);
+        }
+    }
+}
+
+std::string Escape(std::string_view text) {
+    std::string result = "\"";
+    for (const char c : text) {
+        switch (c) {
+        case '\n':
+            result += "\\n"sv;
+            break;
+        case '\r':
+            result += "\\r"sv;
+            break;
+        case '\t':
+            result += "\\t"sv;
+            break;
+        case '"':
+            result += "\\\""sv;
+            break;
+        case '\\':
+            result += "\\\\"sv;
+            break;
+        default:
+            result += c;
+        }
+    }
+    return result + '"';
+}
+
+void CheckRoundTrip(const std::string& text) {
+    std::ostringstream out;
+    json::Writer writer(out);
+    writer.String(text);
+    writer.Flush();
+    const std::string expected = Escape(text);
+    if (out.str() != expected) {
+        Fail("Writer::String gave " + out.str() + " instead of " + expected);
+        return;
+    }
+    if (writer.EncodeString(text) != expected) {
+        Fail("Writer::EncodeString differs from String for " + expected);
+    }
+    std::istringstream in(out.str());
+    if (json::Load(in).GetRoot().AsString() != text) {
+        Fail("Load does not restore " + expected);
+    }
+}
+
+// Escape-последовательности в каждой позиции строки, одна и две подряд
+void TestEscapes() {
+    const std::string_view escaped = SCANS[3].targets;
+    for (size_t length = 1; length <= MAX_LENGTH; ++length) {
+        const std::string plain(length, 'a');
+        CheckRoundTrip(plain);
+        for (size_t pos = 0; pos < length; ++pos) {
+            for (const char c : escaped) {
+                std::string text = plain;
+                text[pos] = c;
+                CheckRoundTrip(text);
+                if (pos + 1 < length) {
+                    text[pos + 1] = '\\';
+                    CheckRoundTrip(text);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestSingleTarget();
+    TestRandomBuffers();
+    TestEscapes();
+    if (failures != 0) {
+        std::cerr << failures << " checks failed\n";
+        return 1;
+    }
+#if defined(JSON_SIMD_SCAN) && defined(__AVX2__)
+    std::cout << "OK: SSE2 and AVX2 scans match the scalar ones\n"sv;
+#elif defined(JSON_SIMD_SCAN)
+    std::cout << "OK: SSE2 scans match the scalar ones\n"sv;
+#else
+    std::cout << "OK: scalar scans only\n"sv;
+#endif
+    return 0;
+}
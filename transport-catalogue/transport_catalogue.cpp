@@ -1,58 +1,107 @@
 
-#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
 #include "transport_catalogue.h"
 namespace catalogue{
 using namespace detail;
-void TransportCatalogue::AddStop(const std::string& stop_name, geo::Coordinates coordinates) {
-	Stop* stop = &stops_.emplace_back(Stop(stop_name, std::move(coordinates.lat), std::move(coordinates.lng)));
+void TransportCatalogue::AddStop(std::string_view stop_name, geo::Coordinates coordinates) {
+	CheckNotFrozen();
+	version_ = NextVersion();
+	Stop* stop = &stops_.emplace_back(names_.Add(stop_name), coordinates.lat, coordinates.lng);
+	stop->id = stops_.size() - 1;
 	stopname_to_stop_[stop->name] = stop;
-	buses_for_stop[stop->name] = {};
 }
 
 Stop* TransportCatalogue::FindStop(std::string_view stop_name) {
-	return stopname_to_stop_.at(std::string{ stop_name });
+	if (frozen_) {
+		return const_cast<Stop*>(std::as_const(*this).FindStop(stop_name));
+	}
+	return stopname_to_stop_.at(stop_name);
 }
 
 const Stop* TransportCatalogue::FindStop(std::string_view stop_name) const {
-	if (stopname_to_stop_.count(std::string{ stop_name })) {
-		return stopname_to_stop_.at(std::string{ stop_name });
+	if (frozen_) {
+		if (stop_slots_.empty()) {
+			return NULL;
+		}
+		const Stop* stop = stop_slots_[stop_hash_.Find(stop_name)];
+		return stop->name == stop_name ? stop : NULL;
+	}
+	const auto it = stopname_to_stop_.find(stop_name);
+	if (it != stopname_to_stop_.end()) {
+		return it->second;
 	}
 	return NULL;
 }
 
-void TransportCatalogue::AddBus(const std::string& bus_name,const std::vector<std::string_view>& stops) {
+void TransportCatalogue::AddBus(std::string_view bus_name,const std::vector<std::string_view>& stops, bool is_roundtrip) {
+	CheckNotFrozen();
  	std::vector<Stop*> stops_for_bus;
-	std::string name = bus_name;
+	stops_for_bus.reserve(stops.size());
 	for (auto& stop : stops) {
 		stops_for_bus.push_back(FindStop(stop));
 	}
-	Bus* bus = &buses_.emplace_back(Bus(bus_name, std::move(stops_for_bus)));
+	AddBus(bus_name, std::move(stops_for_bus), is_roundtrip);
+}
+
+void TransportCatalogue::AddBus(std::string_view bus_name, std::vector<Stop*> stops, bool is_roundtrip) {
+	CheckNotFrozen();
+	version_ = NextVersion();
+	std::vector<Stop*> unique(stops);
+	std::sort(unique.begin(), unique.end());
+	const size_t unique_stop_count = std::unique(unique.begin(), unique.end()) - unique.begin();
+	Bus* bus = &buses_.emplace_back(names_.Add(bus_name), std::move(stops), is_roundtrip);
+	bus->unique_stop_count = unique_stop_count;
 	busname_to_bus_[bus->name] = bus;
-	for (auto& stop : stops) {
-		buses_for_stop.at(stop).push_back(bus->name);
-	}
 }
 
 Bus* TransportCatalogue::FindBus(std::string_view bus_name) {
-	return busname_to_bus_[std::string{bus_name}];
+	if (frozen_) {
+		return const_cast<Bus*>(std::as_const(*this).FindBus(bus_name));
+	}
+	const auto it = busname_to_bus_.find(bus_name);
+	return it != busname_to_bus_.end() ? it->second : nullptr;
 }
 
 const Bus* TransportCatalogue::FindBus(std::string_view bus_name)const {
-	if (busname_to_bus_.count(std::string{ bus_name })) {
-		return busname_to_bus_.at(std::string{ bus_name });
+	if (frozen_) {
+		if (bus_slots_.empty()) {
+			return NULL;
+		}
+		const Bus* bus = bus_slots_[bus_hash_.Find(bus_name)];
+		return bus->name == bus_name ? bus : NULL;
+	}
+	const auto it = busname_to_bus_.find(bus_name);
+	if (it != busname_to_bus_.end()) {
+		return it->second;
 	}
 	return NULL;
 }
 
 void TransportCatalogue::AddStopDistances(std::string_view stop_name, std::unordered_map<std::string_view, int> distances) {
+	CheckNotFrozen();
+	version_ = NextVersion();
 	for (auto dist : distances) {
 		stop_ptr_pair.insert_or_assign({FindStop(stop_name),FindStop(dist.first)}, dist.second);
 	}
 }
 
+void TransportCatalogue::AddStopDistance(Stop* from, Stop* to, int distance) {
+	CheckNotFrozen();
+	version_ = NextVersion();
+	stop_ptr_pair.insert_or_assign({ from, to }, distance);
+}
+
 int TransportCatalogue::DistanceBetweenStops(std::string_view stop1,std::string_view stop2) const {
-	const Stop* from = FindStop(stop1);
-	const Stop* to = FindStop(stop2);
+	return DistanceBetweenStops(FindStop(stop1), FindStop(stop2));
+}
+
+int TransportCatalogue::DistanceBetweenStops(const Stop* from, const Stop* to) const {
+	if (frozen_) {
+		return FrozenDistance(from, to);
+	}
 	if (stop_ptr_pair.count({ const_cast<Stop*>(from),const_cast<Stop*>(to) })) {
 		return stop_ptr_pair.at({ const_cast<Stop*>(from),const_cast<Stop*>(to) });
 	}
@@ -62,7 +111,11 @@ int TransportCatalogue::DistanceBetweenStops(std::string_view stop1,std::string_
 	return 0;
 }
 
-const std::deque<detail::Bus> TransportCatalogue::GetAllBuses() const {
+const std::deque<detail::Stop>& TransportCatalogue::GetAllStops() const {
+	return stops_;
+}
+
+const std::deque<detail::Bus>& TransportCatalogue::GetAllBuses() const {
 	return buses_;
 }
 
@@ -71,26 +124,151 @@ const std::deque<detail::Bus> TransportCatalogue::GetAllBuses() const {
 	if (!bus) {
 		return { 0, 0, 0 ,0};
 	}
-	int unique_stops;
-	int all_stops = static_cast<int>(bus->stops.size());
+	const int unique_stops = static_cast<int>(bus->unique_stop_count);
+	int all_stops = static_cast<int>(bus->GetStopCount());
 	double geographical_distance=0;
 	int actual_distance = 0;
-	std::unordered_set<Stop*> unique;
-	unique.insert(bus->stops.begin(), bus->stops.end());
-	unique_stops = static_cast<int>(unique.size());
-	for (int i = 0; i < static_cast<int>(all_stops) - 1; ++i) {
-		geographical_distance += geo::ComputeDistance({ bus->stops[i]->latitude,bus->stops[i]->longitude }, { bus->stops[i + 1]->latitude,bus->stops[i + 1]->longitude });
-		actual_distance += DistanceBetweenStops(bus->stops[i]->name, bus->stops[i + 1]->name);
+	// Обратный ход некольцевого маршрута проходит те же отрезки: географическое
+	// расстояние удваивается, дорожное берётся в обратном направлении
+	for (size_t i = 0; i + 1 < bus->stops.size(); ++i) {
+		geographical_distance += geo::ComputeDistance(bus->stops[i]->GetPreparedCoordinates(), bus->stops[i + 1]->GetPreparedCoordinates());
+		actual_distance += DistanceBetweenStops(bus->stops[i], bus->stops[i + 1]);
+		if (!bus->is_roundtrip) {
+			actual_distance += DistanceBetweenStops(bus->stops[i + 1], bus->stops[i]);
+		}
+	}
+	if (!bus->is_roundtrip) {
+		geographical_distance *= 2;
 	}
 	return { all_stops,unique_stops,actual_distance, actual_distance/geographical_distance };
 }
 
- std::set<std::string_view> TransportCatalogue::GetStopInfo(std::string_view stop_name)const {
-	 std::set<std::string_view> stop_info;
-	 if (buses_for_stop.at(stop_name).empty()) {
-		 return stop_info;
+ void TransportCatalogue::Finalize() {
+	 std::vector<std::vector<const Bus*>> buses_by_stop(stops_.size());
+	 for (const Bus& bus : buses_) {
+		 for (const Stop* stop : bus.stops) {
+			 buses_by_stop[stop->id].push_back(&bus);
+		 }
+	 }
+	 stop_buses_.clear();
+	 stop_buses_offsets_.assign(1, 0);
+	 stop_buses_offsets_.reserve(stops_.size() + 1);
+	 for (auto& buses : buses_by_stop) {
+		 std::sort(buses.begin(), buses.end(), [](const Bus* lhs, const Bus* rhs) { return lhs->name < rhs->name; });
+		 // Автобус с повторённым именем, как и прежде, выводится один раз
+		 buses.erase(std::unique(buses.begin(), buses.end(), [](const Bus* lhs, const Bus* rhs) {
+			 return lhs->name == rhs->name;
+		 }), buses.end());
+		 stop_buses_.insert(stop_buses_.end(), buses.begin(), buses.end());
+		 stop_buses_offsets_.push_back(stop_buses_.size());
+	 }
+	 spatial_index_ = SpatialIndex(stops_);
+	 prefix_index_ = PrefixIndex(stops_, buses_);
+ }
+
+ TransportCatalogue::BusesRange TransportCatalogue::GetBusesByStop(const Stop* stop) const {
+	 if (!stop || stop->id + 1 >= stop_buses_offsets_.size()) {
+		 return { stop_buses_.end(), stop_buses_.end() };
+	 }
+	 return { stop_buses_.begin() + stop_buses_offsets_[stop->id], stop_buses_.begin() + stop_buses_offsets_[stop->id + 1] };
+ }
+  std::vector<StopDistance> TransportCatalogue::FindNearestStops(geo::Coordinates point, size_t count) const {
+	 return spatial_index_.FindNearest(point, count);
+ }
+
+ std::vector<StopDistance> TransportCatalogue::FindStopsInRadius(geo::Coordinates point, double radius) const {
+	 return spatial_index_.FindInRadius(point, radius);
+ }
+
+ std::vector<NameSuggestion> TransportCatalogue::SuggestNames(std::string_view prefix, size_t count) const {
+	 return prefix_index_.Suggest(prefix, count);
+ }
+
+ void TransportCatalogue::Freeze() {
+	 if (frozen_) {
+		 return;
+	 }
+	 Finalize();
+
+	 // Ключи берутся из словарей имён: при повторном имени, как и при поиске
+	 // до заморозки, находится последнее определение
+	 std::vector<std::string_view> names;
+	 names.reserve(stopname_to_stop_.size());
+	 for (const auto& [name, stop] : stopname_to_stop_) {
+		 names.push_back(name);
+	 }
+	 stop_hash_ = PerfectHash(names);
+	 stop_slots_.assign(names.size(), nullptr);
+	 for (const auto& [name, stop] : stopname_to_stop_) {
+		 stop_slots_[stop_hash_.Find(name)] = stop;
+	 }
+
+	 names.clear();
+	 for (const auto& [name, bus] : busname_to_bus_) {
+		 names.push_back(name);
+	 }
+	 bus_hash_ = PerfectHash(names);
+	 bus_slots_.assign(names.size(), nullptr);
+	 for (const auto& [name, bus] : busname_to_bus_) {
+		 bus_slots_[bus_hash_.Find(name)] = bus;
+	 }
+
+	 std::vector<std::vector<std::pair<size_t, int>>> rows(stops_.size());
+	 for (const auto& [stops, distance] : stop_ptr_pair) {
+		 rows[stops.first->id].emplace_back(stops.second->id, distance);
+	 }
+	 distances_.clear();
+	 distances_.reserve(stop_ptr_pair.size());
+	 distance_offsets_.assign(1, 0);
+	 distance_offsets_.reserve(stops_.size() + 1);
+	 for (auto& row : rows) {
+		 std::sort(row.begin(), row.end());
+		 distances_.insert(distances_.end(), row.begin(), row.end());
+		 distance_offsets_.push_back(distances_.size());
+	 }
+
+	 decltype(stopname_to_stop_){}.swap(stopname_to_stop_);
+	 decltype(busname_to_bus_){}.swap(busname_to_bus_);
+	 decltype(stop_ptr_pair){}.swap(stop_ptr_pair);
+	 frozen_ = true;
+ }
+
+ bool TransportCatalogue::IsFrozen() const {
+	 return frozen_;
+ }
+
+ uint64_t TransportCatalogue::GetVersion() const {
+	 return version_;
+ }
+
+ uint64_t TransportCatalogue::NextVersion() {
+	 static std::atomic<uint64_t> last_version{ 0 };
+	 return ++last_version;
+ }
+
+ void TransportCatalogue::CheckNotFrozen() const {
+	 if (frozen_) {
+		 throw std::logic_error("Catalogue is frozen");
+	 }
+ }
+
+ int TransportCatalogue::FrozenDistance(const Stop* from, const Stop* to) const {
+	 if (!from || !to) {
+		 return 0;
+	 }
+	 auto find_in_row = [this](size_t row, size_t column) {
+		 const auto first = distances_.begin() + distance_offsets_[row];
+		 const auto last = distances_.begin() + distance_offsets_[row + 1];
+		 const auto it = std::lower_bound(first, last, std::pair<size_t, int>{ column, 0 },
+			 [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+		 return it != last && it->first == column ? &it->second : nullptr;
+	 };
+	 if (const int* distance = find_in_row(from->id, to->id)) {
+		 return *distance;
+	 }
+	 if (const int* distance = find_in_row(to->id, from->id)) {
+		 return *distance;
 	 }
-	 stop_info.insert(buses_for_stop.at(stop_name).begin(), buses_for_stop.at(stop_name).end());
-	 return stop_info;
+	 return 0;
  }
  }
\ No newline at end of file
@@ -1,5 +1,11 @@
 #pragma once
 #include "domain.h"
+#include "name_arena.h"
+#include "perfect_hash.h"
+#include "prefix_index.h"
+#include "ranges.h"
+#include "spatial_index.h"
+#include <cstdint>
 #include <string_view>
 #include <unordered_map>
 #include <deque>
@@ -9,23 +15,64 @@ namespace catalogue{
 
 class TransportCatalogue {
 public:
-	void AddStop(const std::string& stop_name, geo::Coordinates coordinates);
+	using BusesRange = ranges::Range<std::vector<const detail::Bus*>::const_iterator>;
+
+	void AddStop(std::string_view stop_name, geo::Coordinates coordinates);
 	const detail::Stop* FindStop(std::string_view stop_name)const;
 	detail::Stop* FindStop(std::string_view stop_name);
-	void AddBus(const std::string& bus_name,const std::vector<std::string_view>& stops);
+	void AddBus(std::string_view bus_name,const std::vector<std::string_view>& stops, bool is_roundtrip);
+	void AddBus(std::string_view bus_name, std::vector<detail::Stop*> stops, bool is_roundtrip);
 	const detail::Bus* FindBus(std::string_view bus_name)const;
 	detail::Bus* FindBus(std::string_view bus_name);
 	void AddStopDistances(std::string_view stop_name, std::unordered_map<std::string_view, int> distances);
+	void AddStopDistance(detail::Stop* from, detail::Stop* to, int distance);
 	int DistanceBetweenStops(std::string_view from, std::string_view to) const;
-	const std::deque<detail::Bus> GetAllBuses() const;
+	int DistanceBetweenStops(const detail::Stop* from, const detail::Stop* to) const;
+	const std::deque<detail::Stop>& GetAllStops() const;
+	const std::deque<detail::Bus>& GetAllBuses() const;
 	std::tuple<int, int, double , double > GetBusInfo(std::string_view bus_name)const;
-	std::set<std::string_view> GetStopInfo(std::string_view stop_name) const;
+	// Строит отсортированные по имени списки автобусов для каждой остановки,
+	// пространственный индекс остановок и индекс имён для поиска по префиксу.
+	// Вызывается один раз после добавления всех остановок и автобусов.
+	void Finalize();
+	BusesRange GetBusesByStop(const detail::Stop* stop) const;
+	std::vector<detail::StopDistance> FindNearestStops(geo::Coordinates point, size_t count) const;
+	std::vector<detail::StopDistance> FindStopsInRadius(geo::Coordinates point, double radius) const;
+	std::vector<detail::NameSuggestion> SuggestNames(std::string_view prefix, size_t count) const;
+	// Переводит справочник в режим только для чтения: поиск по именам идёт через
+	// минимальную совершенную хеш-функцию, расстояния хранятся в плоских массивах,
+	// хеш-таблицы освобождаются. Add* после заморозки бросают std::logic_error.
+	void Freeze();
+	bool IsFrozen() const;
+	// Версия данных: меняется при каждом добавлении и не повторяется у разных
+	// справочников, поэтому по ней можно проверять кэши производных данных
+	uint64_t GetVersion() const;
 private:
+	static uint64_t NextVersion();
+	void CheckNotFrozen() const;
+	int FrozenDistance(const detail::Stop* from, const detail::Stop* to) const;
+
+
+	detail::NameArena names_;
 	std::unordered_map<std::string_view, detail::Stop*> stopname_to_stop_;
 	std::deque<detail::Stop> stops_;
 	std::unordered_map<std::string_view, detail::Bus*> busname_to_bus_;
 	std::deque<detail::Bus> buses_;
-	std::unordered_map<std::string_view, std::vector<std::string_view>> buses_for_stop;
+	std::vector<const detail::Bus*> stop_buses_;
+	std::vector<size_t> stop_buses_offsets_;
+	detail::SpatialIndex spatial_index_;
+	detail::PrefixIndex prefix_index_;
 	std::unordered_map<std::pair<detail::Stop*, detail::Stop*>, int,detail::StopsPairHasher> stop_ptr_pair;
+
+	uint64_t version_ = NextVersion();
+	bool frozen_ = false;
+	detail::PerfectHash stop_hash_;
+	std::vector<detail::Stop*> stop_slots_;
+	detail::PerfectHash bus_hash_;
+	std::vector<detail::Bus*> bus_slots_;
+	// Расстояния от остановки с id i: distances_[distance_offsets_[i]..distance_offsets_[i + 1]),
+	// упорядочены по id остановки назначения
+	std::vector<size_t> distance_offsets_;
+	std::vector<std::pair<size_t, int>> distances_;
 };
 }
\ No newline at end of file
@@ -1,5 +1,54 @@
 #include "transport_router.h"
+#include <algorithm>
+#include <cstdint>
 #include <unordered_map>
+
+namespace {
+const int HILBERT_ORDER = 16;
+
+// Позиция клетки (x, y) решётки 2^HILBERT_ORDER x 2^HILBERT_ORDER на кривой Гильберта
+uint64_t HilbertIndex(uint32_t x, uint32_t y) {
+	uint64_t index = 0;
+	for (uint32_t s = 1u << (HILBERT_ORDER - 1); s > 0; s /= 2) {
+		const uint32_t rx = (x & s) > 0;
+		const uint32_t ry = (y & s) > 0;
+		index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+		if (ry == 0) {
+			if (rx == 1) {
+				x = s - 1 - x;
+				y = s - 1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return index;
+}
+
+std::vector<const catalogue::detail::Stop*> HilbertOrder(const std::deque<catalogue::detail::Stop>& stops) {
+	std::vector<const catalogue::detail::Stop*> result;
+	if (stops.empty()) {
+		return result;
+	}
+	auto [min_lat, max_lat] = std::minmax_element(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) { return lhs.latitude < rhs.latitude; });
+	auto [min_lng, max_lng] = std::minmax_element(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) { return lhs.longitude < rhs.longitude; });
+	const double cells = (1u << HILBERT_ORDER) - 1;
+	auto to_cell = [cells](double value, double min, double max) {
+		return max > min ? static_cast<uint32_t>((value - min) / (max - min) * cells) : 0u;
+	};
+	std::vector<std::pair<uint64_t, const catalogue::detail::Stop*>> keyed;
+	keyed.reserve(stops.size());
+	for (const auto& stop : stops) {
+		keyed.emplace_back(HilbertIndex(to_cell(stop.longitude, min_lng->longitude, max_lng->longitude),
+			to_cell(stop.latitude, min_lat->latitude, max_lat->latitude)), &stop);
+	}
+	std::stable_sort(keyed.begin(), keyed.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+	result.reserve(keyed.size());
+	for (const auto& [index, stop] : keyed) {
+		result.push_back(stop);
+	}
+	return result;
+}
+}
 // Вставьте сюда решние из предыдущего спринта
 
 void TransportRouter::SetWaitTime(int wait_time){
@@ -20,42 +69,91 @@ double TransportRouter::GetVelocity() const
 	return velocity_;
 }
 
+void TransportRouter::SetHilbertOrder(bool enabled) {
+	hilbert_order_ = enabled;
+}
 
-void TransportRouter::ConstructGraph(catalogue::TransportCatalogue& catalogue, const json::Array& stops){
-	size_t k = 0;
+void TransportRouter::FillRoutingSettings(const json::Dict& settings) {
+	SetVelocity(settings.at("bus_velocity").AsDouble());
+	SetWaitTime(settings.at("bus_wait_time").AsInt());
+	if (const auto it = settings.find("hilbert_order"); it != settings.end()) {
+		SetHilbertOrder(it->second.AsBool());
+	}
+}
+
+
+void TransportRouter::ConstructGraph(const catalogue::TransportCatalogue& catalogue){
+	const auto& stops = catalogue.GetAllStops();
+	std::vector<const catalogue::detail::Stop*> order;
+	if (hilbert_order_) {
+		order = HilbertOrder(stops);
+	}
+	else {
+		for (const auto& stop : stops) {
+			order.push_back(&stop);
+		}
+	}
 
-	graph::DirectedWeightedGraph<double> graph(stops.size()*2);
-	for (const json::Node& stop : stops) {
-		stop_edge[stop.AsString()] = {k,k + 1};
-		graph.AddEdge(graph::Edge<double>{ k, k + 1, wait_time_ * 1.0, "", stop.AsString(), 0 });
+	// Вершина ожидания остановки — 2 * позиция, вершина отправления — следующая
+	std::vector<graph::VertexId> wait_vertex(stops.size());
+	graph_ = graph::DirectedWeightedGraph<double>(stops.size() * 2);
+	// Рёбра копятся отдельно, только если их нужно переупорядочить
+	std::vector<graph::Edge<double>> edges;
+	const auto add_edge = [this, &edges](graph::Edge<double>&& edge) {
+		if (hilbert_order_) {
+			edges.push_back(std::move(edge));
+		}
+		else {
+			graph_.AddEdge(edge);
+		}
+	};
+	size_t k = 0;
+	for (const auto* stop : order) {
+		wait_vertex[stop->id] = k;
+		stop_edge[stop->name] = {k,k + 1};
+		add_edge(graph::Edge<double>{ k, k + 1, wait_time_ * 1.0, "", stop->name, 0 });
 		k += 2;
 	}
+	std::vector<const catalogue::detail::Stop*> route;
+	std::vector<double> prefix_distance;
 	for (const auto& bubu : catalogue.GetAllBuses()) {
-		for (int i = 0; i < bubu.stops.size() - 1; ++i) {
-			int span_count=0;
-			double road_distance = 0.0;
-			for (int j = i + 1; j < bubu.stops.size(); ++j) {
-				road_distance += (catalogue.DistanceBetweenStops(bubu.stops[j-1]->name, bubu.stops[j]->name)) * 1.0;
-				graph.AddEdge(graph::Edge<double>{stop_edge[bubu.stops[i]->name].second, stop_edge[bubu.stops[j]->name].first, (road_distance) / (velocity_ * 100 / 6), bubu.name,"",++span_count});
+		// Дорожные расстояния накапливаются за один проход по полному маршруту,
+		// длина любого участка i..j — разность префиксных сумм
+		route.assign(bubu.GetRoute().begin(), bubu.GetRoute().end());
+		prefix_distance.assign(1, 0.0);
+		for (size_t i = 1; i < route.size(); ++i) {
+			prefix_distance.push_back(prefix_distance.back() + catalogue.DistanceBetweenStops(route[i - 1], route[i]));
+		}
+		for (size_t i = 0; i + 1 < route.size(); ++i) {
+			const size_t from = wait_vertex[route[i]->id] + 1;
+			for (size_t j = i + 1; j < route.size(); ++j) {
+				const double road_distance = prefix_distance[j] - prefix_distance[i];
+				add_edge(graph::Edge<double>{from, wait_vertex[route[j]->id], (road_distance) / (velocity_ * 100 / 6), bubu.name,"",static_cast<int>(j - i)});
 			}
 		}
 	}
-	graph_ = graph;
+	if (hilbert_order_) {
+		// Рёбра одной вершины лежат подряд и в порядке номеров вершин
+		std::stable_sort(edges.begin(), edges.end(), [](const auto& lhs, const auto& rhs) { return lhs.from < rhs.from; });
+		for (const auto& edge : edges) {
+			graph_.AddEdge(edge);
+		}
+	}
 	router_ = std::make_unique<graph::Router<double>>(graph_);
 
 }
 
-std::unordered_map<std::string, std::pair<size_t, size_t>> TransportRouter::GetStopEdges()
+const std::unordered_map<std::string_view, std::pair<size_t, size_t>>& TransportRouter::GetStopEdges() const
 {
 	return stop_edge;
 }
 
-const graph::DirectedWeightedGraph<double>& TransportRouter::GetGraph()
+const graph::DirectedWeightedGraph<double>& TransportRouter::GetGraph() const
 {
 	return graph_;
 }
 
-graph::Router<double>* TransportRouter::GetRouter()
+const graph::Router<double>* TransportRouter::GetRouter() const
 {
 		return router_.get();
 }
@@ -1,3 +1,4 @@
+#pragma once
 #include "router.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
@@ -15,18 +16,27 @@ public:
 	int GetWaitTime() const;
 	double GetVelocity() const;
 
-	void ConstructGraph(catalogue::TransportCatalogue& catalogue,const json::Array& stops);
+	// Нумеровать вершины вдоль кривой Гильберта по координатам остановок,
+	// чтобы соседние остановки получали близкие номера вершин и рёбер.
+	// По умолчанию вершины идут в порядке добавления остановок.
+	void SetHilbertOrder(bool enabled);
 
-	std::unordered_map<std::string, std::pair<size_t, size_t>> GetStopEdges();
+	// Скорость, ожидание и порядок вершин из раздела routing_settings
+	void FillRoutingSettings(const json::Dict& settings);
+
+	void ConstructGraph(const catalogue::TransportCatalogue& catalogue);
+
+	const std::unordered_map<std::string_view, std::pair<size_t, size_t>>& GetStopEdges() const;
 	
-	const graph::DirectedWeightedGraph<double>& GetGraph();
+	const graph::DirectedWeightedGraph<double>& GetGraph() const;
 
-	graph::Router<double>* GetRouter();
+	const graph::Router<double>* GetRouter() const;
 
 private:
 	int wait_time_ = 0;
 	double velocity_ = 0.;
+	bool hilbert_order_ = false;
 	graph::DirectedWeightedGraph<double> graph_;
 	std::unique_ptr<graph::Router<double>> router_ = nullptr;
-	std::unordered_map<std::string, std::pair<size_t, size_t>> stop_edge;
+	std::unordered_map<std::string_view, std::pair<size_t, size_t>> stop_edge;
 };
\ No newline at end of file
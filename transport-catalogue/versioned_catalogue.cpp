@@ -0,0 +1,64 @@
+#include "versioned_catalogue.h"
+
+namespace catalogue {
+
+CatalogueVersion::CatalogueVersion(std::unique_ptr<TransportCatalogue> db, json::Dict settings, uint64_t number)
+	:settings_(std::move(settings)), number_(number) {
+	db->Freeze();
+	catalogue_ = std::move(db);
+}
+
+const TransportCatalogue& CatalogueVersion::GetCatalogue() const {
+	return *catalogue_;
+}
+
+const json::Dict& CatalogueVersion::GetSettings() const {
+	return settings_;
+}
+
+uint64_t CatalogueVersion::GetNumber() const {
+	return number_;
+}
+
+const TransportRouter& CatalogueVersion::GetRouter() const {
+	std::call_once(router_once_, [this] {
+		const auto it = settings_.find("routing_settings");
+		if (it == settings_.end()) {
+			throw std::logic_error("No key routing_settings");
+		}
+		router_.FillRoutingSettings(it->second.AsMap());
+		router_.ConstructGraph(*catalogue_);
+		has_router_ = true;
+		});
+	return router_;
+}
+
+bool CatalogueVersion::HasRouter() const {
+	return has_router_;
+}
+
+std::shared_ptr<const CatalogueVersion> VersionedCatalogue::Acquire() const {
+	return std::atomic_load(&current_);
+}
+
+uint64_t VersionedCatalogue::Publish(std::unique_ptr<TransportCatalogue> db, json::Dict settings) {
+	uint64_t number;
+	{
+		std::lock_guard guard(publish_mutex_);
+		number = ++last_number_;
+	}
+	// Тяжёлая работа выполняется вне блокировки и не мешает читателям
+	auto version = std::make_shared<const CatalogueVersion>(std::move(db), std::move(settings), number);
+	if (const auto current = Acquire(); current && current->HasRouter()) {
+		version->GetRouter();
+	}
+
+	std::lock_guard guard(publish_mutex_);
+	const auto current = std::atomic_load(&current_);
+	if (!current || current->GetNumber() < number) {
+		std::atomic_store(&current_, std::shared_ptr<const CatalogueVersion>(std::move(version)));
+	}
+	return number;
+}
+
+}
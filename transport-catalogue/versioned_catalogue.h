@@ -0,0 +1,61 @@
+#pragma once
+#include "transport_router.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace catalogue {
+
+// Неизменяемая версия справочника вместе с настройками документа, из
+// которого она загружена, и маршрутизатором по ней
+class CatalogueVersion {
+public:
+	// Замораживает справочник. settings — разобранные разделы документа
+	// (render_settings, routing_settings): версия не зависит от файла, и его
+	// можно перезаписать, пока она обслуживает запросы.
+	CatalogueVersion(std::unique_ptr<TransportCatalogue> db, json::Dict settings, uint64_t number);
+
+	CatalogueVersion(const CatalogueVersion&) = delete;
+	CatalogueVersion& operator=(const CatalogueVersion&) = delete;
+
+	const TransportCatalogue& GetCatalogue() const;
+	const json::Dict& GetSettings() const;
+	uint64_t GetNumber() const;
+
+	// Маршрутизатор строится по routing_settings при первом обращении, один
+	// раз на версию, даже если обращаются несколько потоков сразу
+	const TransportRouter& GetRouter() const;
+	bool HasRouter() const;
+
+private:
+	std::unique_ptr<const TransportCatalogue> catalogue_;
+	json::Dict settings_;
+	uint64_t number_;
+	mutable std::once_flag router_once_;
+	mutable TransportRouter router_;
+	mutable std::atomic<bool> has_router_ = false;
+};
+
+// Публикация версий справочника в стиле RCU. Читатели закрепляют текущую версию
+// одной атомарной загрузкой указателя и работают с ней без блокировок; писатель
+// готовит следующую версию отдельно и публикует её атомарной заменой указателя.
+// Старая версия освобождается, когда её отпустит последний читатель.
+class VersionedCatalogue {
+public:
+	// Пустой указатель, пока не опубликована ни одна версия
+	std::shared_ptr<const CatalogueVersion> Acquire() const;
+
+	// Публикует новую версию и возвращает её номер. Если текущей версии уже
+	// понадобился маршрутизатор, новая строит свой до публикации, чтобы
+	// читатели его не ждали. Если тем временем успела выйти более новая
+	// версия, эта отбрасывается.
+	uint64_t Publish(std::unique_ptr<TransportCatalogue> db, json::Dict settings);
+
+private:
+	std::shared_ptr<const CatalogueVersion> current_;
+	std::mutex publish_mutex_;
+	uint64_t last_number_ = 0;
+};
+
+}